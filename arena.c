@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "arena.h"
+
+/*
+ * initializes an empty arena, no memory is reserved until first use
+ * params:  arena - arena to initialize
+ *          blockSize - minimum size of each block the arena reserves
+ */
+void arena_init(Arena* arena, size_t blockSize) {
+    arena->head = NULL;
+    arena->current = NULL;
+    arena->blockSize = blockSize;
+}
+
+/*
+ * reserves a new block large enough for the given size 
+ * and chains it after the current block
+ * params:  arena - arena to grow
+ *          size - number of bytes the block must hold
+ * returns: NULL if malloc fails,
+ *          the new block otherwise
+ */
+ArenaBlock* arena_grow(Arena* arena, size_t size) {
+    size_t blockSize = arena->blockSize > size ? arena->blockSize : size;
+    ArenaBlock* block = (ArenaBlock*)malloc(sizeof(ArenaBlock) + blockSize);
+    if(!block) {
+        return NULL;
+    }
+    block->size = blockSize;
+    block->used = 0;
+    block->next = NULL;
+
+    if(arena->current) {
+        block->next = arena->current->next;
+        arena->current->next = block;
+    } else {
+        block->next = arena->head;
+        arena->head = block;
+    }
+
+#ifdef VERBOSE
+    fprintf(stderr, "arena:\tnew block of %lu bytes\n", 
+            (unsigned long)blockSize);
+#endif
+
+    return block;
+}
+
+/*
+ * allocates memory from the arena, reusing blocks kept from earlier resets
+ * params:  arena - arena to allocate from
+ *          size - number of bytes to allocate
+ * returns: NULL if the arena could not grow,
+ *          pointer to uninitialized memory otherwise
+ */
+void* arena_alloc(Arena* arena, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if(!arena->current) {
+        arena->current = arena->head;
+    }
+
+    while(arena->current && arena->current->used + size > 
+            arena->current->size) {
+        if(!arena->current->next) {
+            break;
+        }
+        arena->current = arena->current->next;
+        arena->current->used = 0;
+    }
+
+    if(!arena->current || arena->current->used + size > 
+            arena->current->size) {
+        ArenaBlock* block = arena_grow(arena, size);
+        if(!block) {
+            return NULL;
+        }
+        arena->current = block;
+    }
+
+    void* result = arena->current->data + arena->current->used;
+    arena->current->used += size;
+    return result;
+}
+
+/*
+ * releases everything allocated from the arena at once,
+ * blocks are kept for reuse
+ * params:  arena - arena to reset
+ */
+void arena_reset(Arena* arena) {
+    if(arena->head) {
+        arena->head->used = 0;
+    }
+    arena->current = arena->head;
+}
+
+/*
+ * counts the number of bytes currently allocated from the arena
+ * params:  arena - arena to check
+ * returns: number of bytes in use
+ */
+size_t arena_used(Arena* arena) {
+    size_t used = 0;
+    for(ArenaBlock* block = arena->head; block; block = block->next) {
+        used += block->used;
+        if(block == arena->current) {
+            break;
+        }
+    }
+
+    return used;
+}
+
+/*
+ * frees all memory reserved by the arena
+ * params:  arena - arena to destroy
+ */
+void arena_destroy(Arena* arena) {
+    ArenaBlock* block = arena->head;
+    while(block) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->head = NULL;
+    arena->current = NULL;
+}
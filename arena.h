@@ -0,0 +1,34 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// alignment of every allocation made from an arena
+#define ARENA_ALIGN 16
+
+// a block of arena memory, blocks are chained when the arena grows
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t size;
+    size_t used;
+    char data[];
+} ArenaBlock;
+
+// bump allocator, memory is only released all at once by a reset
+typedef struct {
+    ArenaBlock* head;
+    ArenaBlock* current;
+    size_t blockSize;
+} Arena;
+
+void arena_init(Arena* arena, size_t blockSize);
+
+void* arena_alloc(Arena* arena, size_t size);
+
+void arena_reset(Arena* arena);
+
+size_t arena_used(Arena* arena);
+
+void arena_destroy(Arena* arena);
+
+#endif
@@ -7,6 +7,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
+#include <poll.h>
 #include "err.h"
 #include "common.h"
 #include "card.h"
@@ -14,6 +15,30 @@
 #include "hub.h"
 #include "token.h"
 #include "signalHandler.h"
+#include "eventLog.h"
+#include "options.h"
+#include "result.h"
+#include "plugin.h"
+#include "server.h"
+#include "trace.h"
+#include "metrics.h"
+#include "zygote.h"
+#include "moves.h"
+
+/*
+ * frees the memory held by a game and its session
+ * params:  game - struct containing relevant game information
+ *          session - struct containing hub only information
+ */
+void clear_game(Game* game, Session* session) {
+    shred_stack(&game->stack);
+    shred_stack(&game->hubStack);
+    shred_table(&game->table);
+    free(session->players);
+    shred_player_state(&session->state);
+    free(session->records);
+    arena_destroy(game->arena);
+}
 
 /*
  * clears memory used by hub
@@ -25,16 +50,15 @@ void end_game(Game* game, Session* session, Error err) {
     fprintf(stderr, "[%d]exit:\tgot code %d\n", getpid(), err);
 #endif
 
-    shred_deck(game->stack.deck, game->stack.numCards);
-    shred_deck(game->hubStack.deck, game->hubStack.numCards);
-
     if(session->parentPID == getpid()) {
-        kill_players(game->pCount, session->players, err);
+        log_close();
+        kill_players(game->pCount, session->players, session->records, 
+                err);
+        zygote_stop();
         herr_msg(err);
     }
     
-    free(session->players);
-    free(session->playerStats);
+    clear_game(game, session);
     
     if(err) {
         exit(err);
@@ -49,14 +73,36 @@ void end_game(Game* game, Session* session, Error err) {
  * returns: E_DEADPLAYER if client disconnects,
  *          OK otherwise
  */
-Error send_tokens(int pCount, Player* players, int tokens) {
-    Msg msg = {TOKENS, 0, tokens, 0, 0, 0};
-    return broadcast(pCount, players, &msg); 
+Error send_tokens(Game* game, Session* session, int tokens) {
+    Msg msg = {TOKENS, 0, tokens, 0, 0, 0, 0, 0};
+    return broadcast(game->pCount, session->players, &msg, game->arena); 
+}
+
+/*
+ * sends every card of the deck to the players once, in deck order,
+ * so cards can be named by their id from then on
+ * params:  game - struct containing relevant game information
+ *          session - struct containing hub only information
+ * returns: E_DEADPLAYER if client disconnects,
+ *          OK otherwise
+ */
+Error send_table(Game* game, Session* session) {
+    Msg msg = {CARD, 0, 0, 0, 0, 0, 0, 0};
+    for(int i = 0; i < game->table.numCards; i++) {
+        msg.info = table_card(&game->table, i);
+        if(broadcast(game->pCount, session->players, &msg, 
+                game->arena) != OK) {
+            return E_DEADPLAYER;
+        }
+    }
+
+    return OK;
 }
 
 /*
  * creates the message to send 1 or many cards to players, 
- * moves card from hubstack to stack to keep track of active cards in game
+ * moves card from hubstack to stack to keep track of active cards in game,
+ * interned cards are named by their id
  * params:  game - struct containing relevant game information
  *          session - struct containing hub only information
  *          cards - number of cards to send
@@ -66,19 +112,23 @@ Error send_tokens(int pCount, Player* players, int tokens) {
  */
 Error send_card(Game* game, Session* session, int cards) {
     Error err = OK;
-    Msg msg = {NEWCARD, 0, 0, 0, 0, 0};
-    msg.info = (Card)malloc(sizeof(int) * CARD_SIZE);
+    Msg msg = {NEWCARD, 0, 0, 0, 0, 0, 0, 0};
+    msg.info = (Card)arena_alloc(game->arena, sizeof(int) * CARD_SIZE);
+    int interned = session->options && session->options->interned;
     for(int i = 0; i < cards; i++) {
-        announce_card(game->hubStack.deck[0]);
+        log_card(game->hubStack.deck[0]);
         memcpy(msg.info, game->hubStack.deck[0], sizeof(int) * CARD_SIZE);
-        if(broadcast(game->pCount, session->players, &msg) != OK ||
+        if(interned) { // sent as its id alone
+            msg.info[COLOR] = 0;
+            msg.card = card_id(&game->table, game->hubStack.deck[0]);
+        }
+        if(broadcast(game->pCount, session->players, &msg, 
+                game->arena) != OK ||
                 move_card(&game->hubStack, &game->stack, 0) != OK) {
-            free(msg.info);
             return UTIL;
         }
     }
     
-    free(msg.info);
     return err;
 }
 
@@ -86,32 +136,27 @@ Error send_card(Game* game, Session* session, int cards) {
  * checks if any players have won the game
  * params:  numPoints - number of points to win
  *          pCount - number of players
- *          playerStats - stats of players in game
+ *          state - state of the players in game
  * returns: UTIL if there are winners
  *          OK otherwise
  */
-Error check_win(int winningPoints, int pCount, Game* playerStats) {
+Error check_win(int winningPoints, int pCount, PlayerState* state) {
     int winners = 0;
-    char winList[MAX_PLAYERS] = {0};
+    int winList[MAX_PLAYERS] = {0};
     for(int i = 0; i < pCount; i++) {
 #ifdef TEST
-        printf("%c has %d points\n", i + TOCHAR, playerStats[i].numPoints);
+        char name[ID_SIZE];
+        printf("%s has %d points\n", player_name(i, name), 
+                state->points[i]);
 #endif
 
-        if(playerStats[i].numPoints >= winningPoints) {
-            winList[winners++] = (char)(i + TOCHAR);
+        if(state->points[i] >= winningPoints) {
+            winList[winners++] = i;
         }
     }
 
     if(winners > 0) { // if winners found
-        fprintf(stdout, "Winner(s) ");
-        for(int i = 0; i < winners; i++) {
-            fprintf(stdout, "%c", winList[i]);
-            if(i < winners - 1) {
-                fprintf(stdout, ",");
-            }
-        }
-        fprintf(stdout, "\n");
+        log_winners(winList, winners);
 
         return UTIL;
     }
@@ -120,94 +165,87 @@ Error check_win(int winningPoints, int pCount, Game* playerStats) {
 }
 
 /*
- * updates token amounts for game and player
+ * sums up what has been achieved in a game so far: the bank,
+ * the cards left and every player's points and discounts,
+ * tokens and wilds are left out as they can be taken forever
  * params:  game - struct containing relevant game information
- *          playerStats - players current stats
- *          card - tokens used
- *          position - position of purchased card
- *          wild - wild tokens used
+ *          state - state of the players
+ * returns: fingerprint of the game
  */
-void player_purchase(Game* game, Game* playerStats, Card card, 
-        int position, int wild) {
+uint64_t game_fingerprint(Game* game, PlayerState* state) {
+    uint64_t print = FINGERPRINT_BASIS;
     for(int i = 0; i < TOKEN_SIZE; i++) {
-        game->tokens[i] += card[i + 2];
-        playerStats->ownedTokens[i] -= card[i + 2];
-    }
-    int discountColor = 0;
-    switch(card[COLOR]) {
-        case 'B':
-            discountColor = 1;
-            break;
-        case 'Y':
-            discountColor = 2;
-            break;
-        case 'R':
-            discountColor = 3;
-    }
-    playerStats->discount[discountColor] += 1;
-    playerStats->numPoints += card[POINTS];
-    playerStats->wild -= wild;
-    fprintf(stdout, "Player %c purchased %d using %d,%d,%d,%d,%d\n", 
-            playerStats->pID + TOCHAR, position,
-            card[PURPLE], card[BROWN], card[YELLOW], card[RED], wild);
+        print = (print ^ (uint32_t)game->tokens[i]) * FINGERPRINT_PRIME;
+    }
+    print = (print ^ (uint32_t)game->stack.numCards) * FINGERPRINT_PRIME;
+    print = (print ^ (uint32_t)game->hubStack.numCards) * FINGERPRINT_PRIME;
+    for(int i = 0; i < game->pCount; i++) {
+        print = (print ^ (uint32_t)state->points[i]) * FINGERPRINT_PRIME;
+        for(int j = 0; j < TOKEN_SIZE; j++) {
+            print = (print ^ (uint32_t)state->discount[i][j]) * 
+                    FINGERPRINT_PRIME;
+        }
+    }
+
+    return print;
 }
 
 /*
- * checks if the players requested move is legal
+ * checks at the end of a round that the game can still finish,
+ * points, discounts and cards only ever go one way and the bank
+ * runs out without purchases, so a game that made no progress for 
+ * as many rounds as any card on the board costs in wilds never will
  * params:  game - struct containing relevant game information
- *          playerStats - players current stats
- *          msg - contents of message to check for validity
- * returns: ERR if illegal,
+ *          session - struct containing hub only information
+ * returns: E_ABORTED if the game is past its round limit or stalled,
  *          OK otherwise
  */
-Error valid_move(Game* game, Game playerStats, Msg* msg) {
-    if(msg->type == WILD) {
-#ifdef TEST
-        printf("%c requested wild\n", playerStats.pID + TOCHAR);
-#endif
+Error check_progress(Game* game, Session* session) {
+    Options* options = session->options;
+    if(options && options->maxRounds && 
+            session->rounds >= options->maxRounds) {
+        return E_ABORTED;
+    }
+
+    uint64_t print = game_fingerprint(game, &session->state);
+    if(print != session->fingerprint) {
+        session->fingerprint = print;
+        session->stalled = 0;
         return OK;
-    } 
-    
-    if(msg->type == TAKE) {
-#ifdef TEST
-        printf("%c requested tokens:%d,%d,%d,%d; have:%d,%d,%d,%d\n", 
-                playerStats.pID + TOCHAR, 
-                msg->info[PURPLE], msg->info[BROWN], msg->info[YELLOW], 
-                msg->info[RED], game->tokens[0], game->tokens[1],
-                game->tokens[2], game->tokens[3]);
-#endif
-        if(sum_tokens(msg->info, game->discount) > 3) {
-            return ERR;
-        }
+    }
 
-        for(int i = 0; i < TOKEN_SIZE; i++) {
-            if(msg->info[i + 2] != 1 && msg->info[i + 2] != 0) {
-                return ERR;
-            }
-            
-            if(msg->info[i + 2] == 1 && game->tokens[i] < 1) {
-                return ERR;
-            }
+    int patience = STALL_ROUNDS;
+    for(int i = 0; i < game->stack.numCards; i++) {
+        int cost = 0;
+        for(int j = 0; j < TOKEN_SIZE; j++) {
+            cost += game->stack.deck[i][PURPLE + j];
         }
+        patience = STALL_ROUNDS + cost > patience ? 
+                STALL_ROUNDS + cost : patience;
+    }
 
-        return OK;
-    } 
-    
-    if(msg->type == PURCHASE) {
-#ifdef TEST
-        fprintf(stderr, "%c requested card: ", playerStats.pID + TOCHAR);
-        print_card(game->stack.deck[msg->card], msg->card);
-#endif
-        int wild = can_afford(msg->info, playerStats.discount, 
-                playerStats.ownedTokens, playerStats.wild);
-        if(wild < 0 || (wild > 0 && playerStats.wild < wild)) {
-            return ERR;
-        }
+    return ++session->stalled > patience ? E_ABORTED : OK;
+}
 
-        return OK;
+/*
+ * updates token amounts for game and player
+ * params:  game - struct containing relevant game information
+ *          state - state of the players
+ *          pID - player making the purchase
+ *          card - tokens used
+ *          position - position of purchased card
+ *          wild - wild tokens used
+ */
+void player_purchase(Game* game, PlayerState* state, int pID, Card card, 
+        int position, int wild) {
+    for(int i = 0; i < TOKEN_SIZE; i++) {
+        game->tokens[i] += card[i + 2];
+        state->ownedTokens[pID][i] -= card[i + 2];
     }
-
-    return ERR;
+    state->discount[pID][discount_index(card[COLOR])] += 1;
+    state->points[pID] += card[POINTS];
+    state->wild[pID] -= wild;
+    log_purchase(pID, position, card, wild);
 }
 
 /*
@@ -220,12 +258,14 @@ Error valid_move(Game* game, Game playerStats, Msg* msg) {
  *          OK otherwise
  */
 Error do_move(Game* game, Session* session, Msg* response, int pID) {
-    Msg alert = {-1, 0, 0, 0, 0, 0};
-    alert.info = (Card)calloc(CARD_SIZE, sizeof(int));
+    Msg alert = {-1, 0, 0, 0, 0, 0, 0, 0};
+    alert.info = (Card)arena_alloc(game->arena, sizeof(int) * CARD_SIZE);
+    memset(alert.info, 0, sizeof(int) * CARD_SIZE);
     if(response->type == WILD) {
         alert.type = WILD;
-        session->playerStats[pID].wild++;
-        fprintf(stdout, "Player %c took a wild\n", pID + TOCHAR); 
+        session->state.wild[pID]++;
+        session->records[pID].wilds++;
+        log_wild(pID);
     }
 
     if(response->type == TAKE) {
@@ -233,7 +273,7 @@ Error do_move(Game* game, Session* session, Msg* response, int pID) {
         for(int i = 0; i < TOKEN_SIZE; i++) {
             if(response->info[i + 2]) {
                 game->tokens[i]--;
-                session->playerStats[pID].ownedTokens[i]++;
+                session->state.ownedTokens[pID][i]++;
                 alert.info[i + 2]++;  
             }
         }
@@ -243,9 +283,7 @@ Error do_move(Game* game, Session* session, Msg* response, int pID) {
                 game->tokens[2], game->tokens[3]);
 #endif
 
-        fprintf(stdout, "Player %c drew %d,%d,%d,%d\n", pID + TOCHAR,
-                response->info[PURPLE], response->info[BROWN],
-                response->info[YELLOW], response->info[RED]);
+        log_drew(pID, response->info);
     }
 
     if(response->type == PURCHASE) {
@@ -253,75 +291,289 @@ Error do_move(Game* game, Session* session, Msg* response, int pID) {
         memcpy(alert.info, response->info, CARD_SIZE * sizeof(int));
         alert.card = response->card;
         alert.wild = response->wild;
+        alert.info[COLOR] = game->stack.deck[alert.card][COLOR];
         alert.info[POINTS] = game->stack.deck[alert.card][POINTS];
-        player_purchase(game, &session->playerStats[pID], 
-                alert.info, alert.card, alert.wild);
-        remove_card(&game->stack, alert.card);
+        player_purchase(game, &session->state, pID, alert.info, 
+                alert.card, alert.wild);
+        session->records[pID].cards++;
+        int position = alert.card;
+        if(session->options && session->options->interned) { // by its id
+            alert.card = card_id(&game->table, game->stack.deck[position]);
+        }
+        remove_card(&game->stack, position);
     }
 
-    alert.player = (char)(pID + TOCHAR);
-    Error err = broadcast(game->pCount, session->players, &alert);
-    free(alert.info);
-    free(response->info);
-    return err;
+    alert.player = pID;
+    return broadcast(game->pCount, session->players, &alert, game->arena);
 }
 
 /*
- * asks player for their next move, reprompt on invalid move
- * params:  game - struct containing relevant game information
- *          player - player to retrieve response from
- *          playerStats - players current stats
- *          response - struct to save message contents to
- * returns: type of message received
- *          ERR if error encountered or reprompt returns invalid move
+ * works out why the reply of a player could not be read
+ * returns: E_SIGINT if the hub was interrupted,
+ *          E_DEADPLAYER if the player is gone,
+ *          E_PROTOCOL otherwise
  */
-Comm get_player_move(Game* game, Player player, Game playerStats, 
-        Msg* response) {
+Error read_failure(void) {
+    int signal = check_signal();
 #ifdef TEST
-    fprintf(stderr, "%c stats; points:%d; wild:%d; tokens:%d,%d,%d,%d; "
-            "discount%d,%d,%d,%d\n", playerStats.pID + TOCHAR, 
-            playerStats.numPoints, playerStats.wild,
-            playerStats.ownedTokens[0], playerStats.ownedTokens[1],
-            playerStats.ownedTokens[2], playerStats.ownedTokens[3],
-            playerStats.discount[0], playerStats.discount[1],
-            playerStats.discount[2], playerStats.discount[3]);
+    fprintf(stderr, "interrrupted by signal: %d\n", signal);
 #endif
-    Msg request = {DOWHAT, 0, 0, 0, 0, 0};
-    response->info = (Card)malloc(sizeof(int) * CARD_SIZE);
-    char* line;
-    for(int i = 0; i < 2; i++) {
-#ifdef TEST
-        if(i) {
-            printf("reprompting\n");
+
+    if(errno == EINTR || signal == E_SIGINT) {
+        return E_SIGINT;
+    } 
+    if(signal == E_DEADPLAYER) {
+        return E_DEADPLAYER;
+    }
+
+    return E_PROTOCOL;
+}
+
+/*
+ * builds the dowhat for the player whose turn it is, carrying what is 
+ * left of its budgets, a spent game budget is sent as a millisecond
+ * params:  session - struct containing hub only information
+ * returns: the dowhat, its budgets are 0 if the hub keeps none
+ */
+Msg dowhat(Session* session) {
+    Msg request = {DOWHAT, 0, 0, 0, 0, 0, 0, 0};
+    Options* options = session->options;
+    if(!options) {
+        return request;
+    }
+
+    request.moveBudget = options->moveBudget;
+    if(options->gameBudget) {
+        long long left = options->gameBudget - 
+                (long long)(session->records[session->turn].thought / 
+                1000000ULL);
+        request.gameBudget = left > 0 ? (int)left : 1;
+    }
+    return request;
+}
+
+/*
+ * asks the player whose turn it is for their move and sets the deadline 
+ * of its reply, plugins are asked when their move is taken instead,
+ * the grace of the game budget is given once over the game, not per move,
+ * so a player past its game budget has no time left at all
+ * params:  game - struct containing relevant game information
+ *          session - struct containing hub only information
+ * returns: E_DEADPLAYER if client disconnects,
+ *          OK otherwise
+ */
+Error prompt_player(Game* game, Session* session) {
+    Player* player = &session->players[session->turn];
+    Msg request = dowhat(session);
+    session->prompted = metrics_now();
+    session->deadline = request.moveBudget ? session->prompted + 
+            (uint64_t)(request.moveBudget + BUDGET_GRACE) * 1000000ULL : 0;
+    if(request.gameBudget) {
+        uint64_t allowed = (uint64_t)(session->options->gameBudget + 
+                BUDGET_GRACE) * 1000000ULL;
+        uint64_t thought = session->records[session->turn].thought;
+        uint64_t end = session->prompted + 
+                (allowed > thought ? allowed - thought : 0);
+        if(!session->deadline || end < session->deadline) {
+            session->deadline = end;
         }
+    }
+    if(player->plugin) {
+        return OK;
+    }
+
+    return send_msg(&request, player->toChild, game->arena);
+}
+
+/*
+ * waits for the reply of the player whose turn it is, 
+ * no longer than its deadline
+ * params:  session - struct containing hub only information
+ *          reader - where the reply of the player is read from
+ * returns: E_TIMEOUT if the deadline passed first,
+ *          E_SIGINT or E_DEADPLAYER if a signal was caught,
+ *          OK once reader_line would not block
+ */
+Error await_reply(Session* session, Reader* reader) {
+    while(session->deadline && !reader_has_line(reader)) {
+        uint64_t now = metrics_now();
+        if(now >= session->deadline) {
+            return E_TIMEOUT;
+        }
+        struct pollfd ready = {reader->fd, POLLIN, 0};
+        int count = poll(&ready, 1, 
+                (int)((session->deadline - now + 999999) / 1000000));
+        if(count < 0 && check_signal()) {
+            return read_failure();
+        }
+        if(count > 0 && reader_fill(reader) <= 0) {
+            break; // reader_line sees the end of the pipe
+        }
+    }
+
+    return OK;
+}
+
+/*
+ * starts the turn of the next player
+ * params:  game - struct containing relevant game information
+ *          session - struct containing hub only information
+ * returns: E_DEADPLAYER if client disconnects,
+ *          OK otherwise
+ */
+Error begin_turn(Game* game, Session* session) {
+    arena_reset(game->arena); // a new turn, messages are done with
+    session->attempt = 0;
+    METRIC_ADD(turns, 1);
+#ifdef TEST
+    int pID = session->turn;
+    PlayerState* state = &session->state;
+    fprintf(stderr, "%d stats; points:%d; wild:%d; tokens:%d,%d,%d,%d; "
+            "discount%d,%d,%d,%d\n", pID, 
+            state->points[pID], state->wild[pID],
+            state->ownedTokens[pID][0], state->ownedTokens[pID][1],
+            state->ownedTokens[pID][2], state->ownedTokens[pID][3],
+            state->discount[pID][0], state->discount[pID][1],
+            state->discount[pID][2], state->discount[pID][3]);
 #endif
 
-        send_msg(&request, player.toChild);
-        line = read_line(player.fromChild, 0, 0);
+    return prompt_player(game, session);
+}
 
+/*
+ * sends the pre-game setup and asks the first player for their move
+ * params:  game - struct containing relevant game information
+ *          session - struct containing hub only information
+ * returns: E_DEADPLAYER if client disconnects,
+ *          OK otherwise
+ */
+Error begin_game(Game* game, Session* session) {
+    METRIC_ADD(gamesRunning, 1);
+    session->turn = 0;
+    session->fingerprint = 0;
+    session->stalled = 0;
+    if(session->options && session->options->interned && 
+            send_table(game, session) != OK) {
+        return E_DEADPLAYER;
+    }
+    if(send_tokens(game, session, game->tokens[0]) != OK ||
+            send_card(game, session, BOARD_SIZE) != OK) { // pre-game setup
+        return E_DEADPLAYER;
+    }
+
+    return begin_turn(game, session);
+}
+
+/*
+ * takes the reply of the player whose turn it is, an invalid move is 
+ * reprompted once, a valid one is executed and the next player asked,
+ * which is sent the move first so it can speculate on its own,
+ * the win condition is checked after every round
+ * params:  game - struct containing relevant game information
+ *          session - struct containing hub only information
+ *          line - reply of the player, NULL for a plugin
+ * returns: E_DEADPLAYER if client disconnects,
+ *          E_PROTOCOL if client is being naughty,
+ *          E_TIMEOUT if the reply came after its deadline,
+ *          E_ABORTED if the game stalled or hit its round limit,
+ *          UTIL if the game has been won,
+ *          OK otherwise
+ */
+Error take_move(Game* game, Session* session, char* line) {
+    Player* player = &session->players[session->turn];
+    Msg response = {-1, 0, 0, 0, 0, 0, 0, 0};
+    response.info = (Card)arena_alloc(game->arena, sizeof(int) * CARD_SIZE);
+    Comm type;
+    if(player->plugin) { // the move is passed back as a struct
+        Msg request = dowhat(session);
+        type = plugin_move(player->plugin, &request, &response);
+    } else {
 #ifdef VERBOSE 
         fprintf(stderr, "got line: %s\n", line);
 #endif
+        type = decode_player_msg(&response, line);
+        METRIC_ADD(bytesReceived, strlen(line) + 1);
+    }
+    METRIC_ADD(received, 1);
+    uint64_t now = metrics_now();
+    metrics_move(session->turn, now - session->prompted);
+    session->records[session->turn].thought += now - session->prompted;
+    if(session->deadline && now > session->deadline) {
+        METRIC_ADD(timeouts, 1);
+        return E_TIMEOUT;
+    }
 
-        if(line == NULL || check_signal()) {
+    uint64_t start = trace_begin();
+    Error valid = (int)type == ERR ? ERR : valid_move(game, 
+            &session->state, session->turn, &response);
+    trace_end("valid_move", start);
+    if(valid != OK) {
+        if(++session->attempt > 1) {
+            METRIC_ADD(protocolErrors, 1);
+            return E_PROTOCOL;
+        }
+        METRIC_ADD(reprompts, 1);
 #ifdef TEST
-            fprintf(stderr, "interrrupted by signal: %d, line:%s\n",
-                    check_signal(), line);
+        printf("reprompting\n");
 #endif
+        return prompt_player(game, session);
+    }
 
-            free(line);
-            free(response->info);
-            return ERR;   
-        }
+    start = trace_begin();
+    Error err = do_move(game, session, &response, session->turn);
+    trace_end("do_move", start);
+    if(!err && response.type == PURCHASE && 
+            game->hubStack.numCards > 0) { // if card was bought
+        err = send_card(game, session, 1);
+    }
+    if(err) {
+        return err;
+    }
+    Player* next = &session->players[(session->turn + 1) % game->pCount];
+    if(!next->plugin) { // it can work out its move while the round is done
+        fflush(next->toChild);
+    }
 
-        if((int)decode_player_msg(response, line) != ERR && 
-                valid_move(game, playerStats, response) == OK) {
-            return response->type;
+    if(++session->turn == game->pCount) { // end of the round
+        session->turn = 0;
+        session->rounds++;
+        err = check_win(game->numPoints, game->pCount, &session->state);
+        if(!err) {
+            err = check_progress(game, session);
+        }
+        if(err) {
+            return err;
         }
     }
-    
-    free(response->info);
-    return ERR;
+
+    return begin_turn(game, session);
+}
+
+/*
+ * counts the end of a game and tells the players if it was won,
+ * players may leave as soon as they see eog, so later sends failing
+ * does not change the outcome
+ * params:  game - struct containing relevant game information
+ *          session - struct containing hub only information
+ *          err - what ended the game, UTIL if it was won
+ * returns: OK if the game was won,
+ *          E_ABORTED if it was stopped, the players still see eog
+ *          err otherwise
+ */
+Error finish_game(Game* game, Session* session, Error err) {
+    METRIC_ADD(gamesRunning, -1);
+    if(err == UTIL) {
+        METRIC_ADD(gamesFinished, 1);
+    } else {
+        METRIC_ADD(gamesFailed, 1);
+    }
+
+    if(err == UTIL || err == E_ABORTED) { // aborted games end without winners
+        Msg endGame = {EOG, 0, 0, 0, 0, 0, 0, 0};
+        broadcast(game->pCount, session->players, &endGame, game->arena);
+    }
+
+    return err == UTIL ? OK : err;
 }
 
 /*
@@ -334,72 +586,83 @@ Comm get_player_move(Game* game, Player player, Game playerStats,
  *          session - struct containing hub only information
  * returns: E_DEADPLAYER if client disconnects,
  *          E_PROTOCOL if client is being naughty
+ *          E_TIMEOUT if a player ran out of time
+ *          E_ABORTED if the game stalled or hit its round limit
  *          E_SIGINT if sigint was caught
- *          UTIL otherwise for end of game 
+ *          OK otherwise for end of game 
  */
 Error start_hub(Game* game, Session* session) {
-    if(send_tokens(game->pCount, session->players, game->tokens[0]) != OK ||
-            send_card(game, session, 8) != OK) { // pre-game setup
-        return E_DEADPLAYER;
-    }
-
-    int signal;
-    Error err = OK;
-    while((signal = check_signal()), !signal && err == OK) {
-        for(int i = 0; i < game->pCount; i++) {
-            Msg response = {-1, 0, 0, 0, 0, 0};
-            if((int)get_player_move(game, session->players[i], // get move
-                    session->playerStats[i], &response) == ERR) {
-                signal = check_signal();
-                if(errno == EINTR || signal == E_SIGINT) {
-                    err = E_SIGINT;
-                } else if(signal == E_DEADPLAYER) {
-                    err = E_DEADPLAYER;
-                } else {
-                    err = E_PROTOCOL;
-                }
+    Error err = begin_game(game, session);
+    while(!err) {
+        Player* player = &session->players[session->turn];
+        if(player->plugin) {
+            err = take_move(game, session, NULL);
+        } else {
+            err = await_reply(session, &player->fromChild);
+            if(err) {
                 break;
             }
-            
-            err = do_move(game, session, &response, i); // execute move
-            if(!err && response.type == PURCHASE && 
-                    game->hubStack.numCards > 0) { // if card was bought
-                err = send_card(game, session, 1);
+            uint64_t start = trace_begin();
+            char* line = reader_line(&player->fromChild, 0, 0);
+            trace_end("read_line", start);
+            if(line == NULL || check_signal()) {
+                err = read_failure();
+            } else {
+                err = take_move(game, session, line);
             }
         }
-        if(!err) { // check for winners
-            err = check_win(game->numPoints, game->pCount, 
-                    session->playerStats);
+        if(!err) {
+            err = check_signal();
         }
     }
 
-    if(err == UTIL) {
-        Msg endGame = {EOG, 0, 0, 0, 0, 0};
-        err = broadcast(game->pCount, session->players, &endGame);
-        return err;
-    }
-
-    if(!err) {
-        return signal;
-    }
-
-    return err;
+    return finish_game(game, session, err);
 }
 
 int main(int argc, char** argv) {
     Game game;
     Session session;
+    Arena arena;
+    arena_init(&arena, TURN_BLOCK);
+    game.arena = &arena;
 
 #ifdef TEST
     printf("parent PID:\t%d\n", getpid());
 #endif
     
+    Options options;
+    int first;
+    Error err = parse_options(argc, argv, &options, &first);
+    if(err) {
+        herr_msg(err);
+        return err;
+    }
+    session.options = &options;
+    trace_open("hub", 1);
+    place_hub(options.placement);
+    if(options.statsFile && metrics_open(options.statsFile) != OK) {
+        herr_msg(E_ARGV);
+        return E_ARGV;
+    }
+    if(options.zygote && zygote_start(&options) != OK) {
+        herr_msg(E_EXEC);
+        return E_EXEC;
+    }
+    if(options.jobFile) { // serve the jobs instead of a single game
+        arena_destroy(&arena);
+        err = first == argc ? run_server(&options) : E_ARGC;
+        zygote_stop();
+        herr_msg(err);
+        return err;
+    }
+    argc -= first - 1; // positional arguments now start at argv[1]
+    argv += first - 1;
+
     if(argc < 6 || argc - 4 > MAX_PLAYERS) {
         herr_msg(E_ARGC);
         return E_ARGC;
     }
     
-    Error err = OK;
     err = hub_init(argv, &game);
     if(err) {
         herr_msg(err);
@@ -414,16 +677,25 @@ int main(int argc, char** argv) {
     int signalList[] = {SIGINT, SIGPIPE, SIGCHLD};
     init_signal_handler(signalList, 3);
 
-    if(start_players(argc - 4, argv + 4, &game, &session) != OK ||
-            getpid() != session.parentPID) {
+    if(start_players(argc - 4, argv + 4, &game, &session) != OK) {
         end_game(&game, &session, E_EXEC);
-    } // no child should go past here
+    }
+
+    if(log_open(options.logSink, STDOUT_FILENO) != OK) {
+        end_game(&game, &session, E_EXEC);
+    }
     
 #ifdef TEST
     printf("game starting\n");
 #endif
 
     err = start_hub(&game, &session);
+    log_close();
+    kill_players(game.pCount, session.players, session.records, err);
+    write_result(&game, &session, err);
+    if(options.usage) {
+        report_usage(&game, &session);
+    }
     end_game(&game, &session, err);
     
 #ifdef TEST
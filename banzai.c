@@ -5,6 +5,7 @@
 #include "err.h"
 #include "common.h"
 #include "playerCommon.h"
+#include "plugin.h"
 #include "comms.h"
 #include "card.h"
 #include "token.h"
@@ -126,33 +127,34 @@ Msg* banzai_move(Game* game, ...) {
             game->tokens[2], game->tokens[3]);
 #endif
 
-    Msg* msg = (Msg*)malloc(sizeof(Msg));
+    Msg* msg = (Msg*)arena_alloc(game->arena, sizeof(Msg));
     int ownedTokenSum = game->ownedTokens[0] + game->ownedTokens[1] + 
             game->ownedTokens[2] + game->ownedTokens[3] + game->wild;
     int tokenOrder[] = {YELLOW - 2, BROWN - 2, PURPLE - 2, RED - 2};
-    int* tokens = get_tokens(game->tokens, tokenOrder);
+    int* tokens = get_tokens(game->arena, game->tokens, tokenOrder);
     if(tokens && ownedTokenSum < 3) { // take tokens
         msg->type = TAKE;
-        msg->info = (Card)malloc(sizeof(int) * CARD_SIZE);
+        msg->info = (Card)arena_alloc(game->arena,
+                sizeof(int) * CARD_SIZE);
         memcpy(msg->info + 2, tokens, sizeof(int) * TOKEN_SIZE);
 
 #ifdef TEST
         fprintf(stderr, "taking:\t%d,%d,%d,%d\n", 
                 tokens[0], tokens[1], tokens[2], tokens[3]);
 #endif
-        free(tokens);
     } else { // take card
         int chosenCard = choose_card(game);
         if(chosenCard > -1) {
             msg->type = PURCHASE;
             msg->card = chosenCard;
-            msg->info = (Card)malloc(sizeof(int) * CARD_SIZE);
+            msg->info = (Card)arena_alloc(game->arena,
+                    sizeof(int) * CARD_SIZE);
             msg->wild = can_afford(game->stack.deck[chosenCard], 
                     game->discount, game->ownedTokens, game->wild);
-            int* usedTokens = get_card_cost(game->discount, game->ownedTokens,
+            int* usedTokens = get_card_cost(game->arena, game->discount,
+                    game->ownedTokens, game->wild, 
                     game->stack.deck[chosenCard]);
             memcpy(msg->info + 2, usedTokens, sizeof(int) * TOKEN_SIZE);
-            free(usedTokens); 
         } else { // take wild
             msg->type = WILD;
         }
@@ -160,6 +162,10 @@ Msg* banzai_move(Game* game, ...) {
     return msg;
 }
 
+#ifdef PLUGIN
+// lets the hub load banzai as a plugin, it keeps no state of its own
+Strategy strategy = {PLUGIN_ABI, NULL, &banzai_move, NULL, 1};
+#else
 int main(int argc, char** argv) {
     if(argc != 3) {
         perr_msg(E_ARGC, BANZAI);
@@ -184,7 +190,7 @@ int main(int argc, char** argv) {
     int signalList[] = {SIGPIPE};
     init_signal_handler(signalList, 1);
     
-    Error err = play_game(&game, &banzai_move);
+    Error err = play_game(&game, &banzai_move, 1);
     if(err == UTIL) {
         err = OK;
     }
@@ -193,11 +199,7 @@ int main(int argc, char** argv) {
         err = E_COMMERR;
     }
     
-    if(game.stack.numCards) {
-        shred_deck(game.stack.deck, game.stack.numCards);
-    } else {
-        free(game.stack.deck);
-    }
+    shred_player_game(&game);
 
 #ifdef TEST
     fprintf(stderr, "banzai exiting\n");
@@ -206,3 +208,4 @@ int main(int argc, char** argv) {
     perr_msg(err, BANZAI); 
     return err;
 }
+#endif
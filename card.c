@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include "err.h"
@@ -28,17 +29,6 @@ void print_deck(Deck deck, int numCards) {
     }
 }
 
-/*
- * announces card to stdout
- * params:  card - card to print
- */
-void announce_card(Card card) {
-    fprintf(stdout, "New card = Bonus %c, worth %d, costs %d,%d,%d,%d\n",
-            (char)card[COLOR], card[POINTS],
-            card[PURPLE], card[BROWN],
-            card[YELLOW], card[RED]);
-}
-
 /*
  * a wrapper for add_card and remove_card, 
  * moves card from stack1 to stack2
@@ -48,7 +38,13 @@ void announce_card(Card card) {
  *          OK otherwise
  */
 Error move_card(Stack* source, Stack* destination, int card) {
-    if(new_card(destination, source->deck[card]) != OK) {
+    if(card < 0 || card >= source->numCards) {
+        return ERR;
+    }
+    Error added = destination->shared ? 
+            share_card(destination, source->deck[card]) :
+            new_card(destination, source->deck[card]);
+    if(added != OK) {
         return ERR;
     }
 
@@ -135,6 +131,13 @@ Error remove_card(Stack* stack, int card) {
         return ERR;
     }
 
+    if(stack->shared) { // the table keeps the card
+        memmove(&stack->deck[card], &stack->deck[card + 1],
+                sizeof(Card) * (stack->numCards - card - 1));
+        stack->numCards--;
+        return OK;
+    }
+
     if(card != stack->numCards - 1) {
         for(int i = card; i < stack->numCards - 1; i++) {
             for(int j = 0; j < CARD_SIZE; j++) {
@@ -208,7 +211,50 @@ char* card_to_string(Card card) {
 }
 
 /*
- * checks contents of deck and saves to memory
+ * checks if a card read from a deck file is valid
+ * params:  color - color of the card
+ *          costs - points followed by the 4 token costs
+ * returns: ERR if invalid,
+ *          OK otherwise
+ */
+Error check_card(int color, int* costs) {
+    if(!color || !strchr("PBYR", color)) {
+        return ERR;
+    }
+    for(int i = 0; i < CARD_SIZE - 1; i++) {
+        if(costs[i] < 0) {
+            return ERR;
+        }
+    }
+
+    return OK;
+}
+
+/*
+ * reads the cards of a binary deck, the magic has already been read
+ * params:  deckFile - file containing deck
+ *          stack - struct containing relevant stack information
+ * returns: ERR if invalid contents,
+ *          OK otherwise
+ */
+Error read_binary_deck(FILE* deckFile, Stack* stack) {
+    int32_t card[CARD_SIZE];
+    size_t got;
+    while((got = fread(card, sizeof(int32_t), CARD_SIZE, deckFile)) == 
+            CARD_SIZE) {
+        if(check_card(card[COLOR], card + POINTS) != OK || 
+                add_card(stack, (char)card[COLOR], card[POINTS], 
+                card[PURPLE], card[BROWN], card[YELLOW], card[RED]) != OK) {
+            return ERR;
+        }
+    }
+
+    return got || !stack->numCards ? ERR : OK;
+}
+
+/*
+ * checks contents of deck and saves to memory, 
+ * the deck is either text or binary (see DECK_MAGIC)
  * params:  deckFile - file containing deck
  *          stack - struct containing relevant stack information
  * returns: ERR if invalid contents,
@@ -216,8 +262,21 @@ char* card_to_string(Card card) {
  */
 Error read_deck(FILE* deckFile, Stack* stack) {
     Error err = OK;
+    int first = getc(deckFile);
+    if(first == DECK_MAGIC[0]) {
+        char magic[sizeof(DECK_MAGIC)] = {0};
+        size_t rest = strlen(DECK_MAGIC) - 1;
+        if(fread(magic, 1, rest, deckFile) != rest || 
+                strcmp(magic, DECK_MAGIC + 1)) {
+            return ERR;
+        }
+        err = read_binary_deck(deckFile, stack);
+    } else if(first != EOF) {
+        ungetc(first, deckFile);
+    }
+
     char* line = (char*)malloc(sizeof(char) * LINE_BUFF);
-    while(1) {
+    while(first != DECK_MAGIC[0]) {
         if(fgets(line, LINE_BUFF, deckFile) == NULL) {
             if(!stack->numCards) {
                 err = ERR;
@@ -226,13 +285,10 @@ Error read_deck(FILE* deckFile, Stack* stack) {
         }
       
         char color, end;
-        int res, points, purple, brown, yellow, red;
-        res = sscanf(line, "%c:%d:%d,%d,%d,%d%c", 
-                &color, &points, &purple, &brown, &yellow, &red, &end);
-        char* validColors = "PBYR";
-        if(res != 7 || end != '\n' || strspn(&color, validColors) != 1 || 
-                points < 0 || purple < 0 || brown < 0 || yellow < 0 || 
-                red < 0) {
+        int res, costs[CARD_SIZE - 1];
+        res = sscanf(line, "%c:%d:%d,%d,%d,%d%c", &color, &costs[0], 
+                &costs[1], &costs[2], &costs[3], &costs[4], &end);
+        if(res != 7 || end != '\n' || check_card(color, costs) != OK) {
             err = ERR;
             break;
         }
@@ -241,9 +297,10 @@ Error read_deck(FILE* deckFile, Stack* stack) {
         fprintf(stderr, "fgets:\t%s", line);
 #endif
 
-        if(add_card(stack, color, points, 
-                purple, brown, yellow, red) != OK) {
-            return ERR;
+        if(add_card(stack, color, costs[0], 
+                costs[1], costs[2], costs[3], costs[4]) != OK) {
+            err = ERR;
+            break;
         }
     }
     free(line);
@@ -254,8 +311,166 @@ Error read_deck(FILE* deckFile, Stack* stack) {
     
     if(stack->numCards != 0 && err != OK) {
         shred_deck(stack->deck, stack->numCards);
+        stack->deck = NULL; // nothing left for the caller to shred
+        stack->numCards = 0;
     }
 
     return err;
 }
 
+/*
+ * frees the memory used by a stack, cards of a shared stack are left
+ * to their table
+ * params:  stack - stack to free
+ */
+void shred_stack(Stack* stack) {
+    if(stack->shared) {
+        free(stack->deck);
+    } else if(stack->numCards) {
+        shred_deck(stack->deck, stack->numCards);
+    } else {
+        free(stack->deck);
+    }
+    stack->deck = NULL;
+    stack->numCards = 0;
+}
+
+/*
+ * appends a copy of a card to a table, the table doubles as it fills
+ * so pointers into it only hold once it is complete
+ * params:  table - table to add to
+ *          card - card to copy
+ * returns: ERR if the card is invalid or memory runs out,
+ *          OK otherwise
+ */
+Error table_add(CardTable* table, Card card) {
+    if(check_card(card[COLOR], card + POINTS) != OK) {
+        return ERR;
+    }
+    int count = table->numCards;
+    if(!(count & (count - 1))) { // a power of two or empty, full
+        int* cards = (int*)realloc(table->cards, 
+                sizeof(int) * CARD_SIZE * (count ? count * 2 : 1));
+        if(!cards) {
+            return ERR;
+        }
+        table->cards = cards;
+    }
+
+    memcpy(table->cards + count * CARD_SIZE, card, sizeof(int) * CARD_SIZE);
+    table->numCards++;
+    return OK;
+}
+
+/*
+ * reads a deck, text or binary, into a table
+ * params:  deckFile - file containing deck
+ *          table - empty table to fill
+ * returns: ERR if invalid contents,
+ *          OK otherwise
+ */
+Error read_table(FILE* deckFile, CardTable* table) {
+    Stack stack = {0, (Deck)malloc(sizeof(Card)), 0};
+    Error err = read_deck(deckFile, &stack);
+    for(int i = 0; !err && i < stack.numCards; i++) {
+        err = table_add(table, stack.deck[i]);
+    }
+    shred_stack(&stack);
+
+    return err;
+}
+
+/*
+ * finds a card of a table by its id
+ * params:  table - table to look in
+ *          id - index of the card
+ * returns: NULL if there is no such card,
+ *          the card otherwise, owned by the table
+ */
+Card table_card(CardTable* table, int id) {
+    if(id < 0 || id >= table->numCards) {
+        return NULL;
+    }
+
+    return table->cards + id * CARD_SIZE;
+}
+
+/*
+ * finds the id of a card held by a table
+ * params:  table - table holding the card
+ *          card - card of a shared stack
+ * returns: ERR if the card is not in the table,
+ *          id of the card otherwise
+ */
+int card_id(CardTable* table, Card card) {
+    if(card < table->cards || 
+            card >= table->cards + table->numCards * CARD_SIZE) {
+        return ERR;
+    }
+
+    return (int)((card - table->cards) / CARD_SIZE);
+}
+
+/*
+ * adds a card of a table to a shared stack without copying it
+ * params:  stack - shared stack to add to
+ *          card - card owned by the table
+ * returns: ERR if memory runs out,
+ *          OK otherwise
+ */
+Error share_card(Stack* stack, Card card) {
+    if(stack->numCards) { // as with add_card, the first slot is there
+        Deck deck = (Deck)realloc(stack->deck, 
+                sizeof(Card) * (stack->numCards + 1));
+        if(!deck) {
+            return ERR;
+        }
+        stack->deck = deck;
+    }
+
+    stack->deck[stack->numCards++] = card;
+    return OK;
+}
+
+/*
+ * finds where a card of a table lies in a shared stack
+ * params:  stack - shared stack to search
+ *          card - card owned by the table
+ * returns: ERR if the card is not in the stack,
+ *          position of the card otherwise
+ */
+int find_card(Stack* stack, Card card) {
+    for(int i = 0; card && i < stack->numCards; i++) {
+        if(stack->deck[i] == card) {
+            return i;
+        }
+    }
+
+    return ERR;
+}
+
+/*
+ * makes a shared stack of every card of a table in table order
+ * params:  table - complete table
+ *          stack - stack to fill, any deck it had is freed
+ */
+void share_table(CardTable* table, Stack* stack) {
+    free(stack->deck);
+    stack->deck = (Deck)malloc(sizeof(Card) * 
+            (table->numCards ? table->numCards : 1));
+    for(int i = 0; i < table->numCards; i++) {
+        stack->deck[i] = table->cards + i * CARD_SIZE;
+    }
+    stack->numCards = table->numCards;
+    stack->shared = 1;
+}
+
+/*
+ * frees the cards of a table, shared stacks must not be used after
+ * params:  table - table to free
+ */
+void shred_table(CardTable* table) {
+    free(table->cards);
+    table->cards = NULL;
+    table->numCards = 0;
+}
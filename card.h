@@ -15,21 +15,32 @@
 #define YELLOW 4
 #define RED 5
 
+// a deck file starting with this is binary, the magic is followed by 
+// CARD_SIZE 32 bit values in host byte order for every card
+#define DECK_MAGIC "\177deck1\n"
+
 typedef int* Card;
 typedef Card* Deck;
 
-// struct to hold deck relevant information
+// struct to hold deck relevant information,
+// a shared stack points into a card table and owns none of its cards
 typedef struct {
     int numCards;
     Deck deck;
+    int shared;
 } Stack;
 
+// every card of a deck stored once in the order of the deck, 
+// CARD_SIZE ints each, the id of a card is its index in the table
+typedef struct {
+    int numCards;
+    int* cards;
+} CardTable;
+
 void print_card(Card card, int position);
 
 void print_deck(Deck deck, int numCards);
 
-void announce_card(Card card);
-
 Error move_card(Stack* source, Stack* destination, int card);
 
 Error new_card(Stack* stack, Card card);
@@ -48,4 +59,22 @@ char* card_to_string(Card card);
 
 Error read_deck(FILE* deckFile, Stack* stack);
 
+void shred_stack(Stack* stack);
+
+Error table_add(CardTable* table, Card card);
+
+Error read_table(FILE* deckFile, CardTable* table);
+
+Card table_card(CardTable* table, int id);
+
+int card_id(CardTable* table, Card card);
+
+Error share_card(Stack* stack, Card card);
+
+int find_card(Stack* stack, Card card);
+
+void share_table(CardTable* table, Stack* stack);
+
+void shred_table(CardTable* table);
+
 #endif
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <time.h>
 #include "common.h"
 #include "err.h"
 
@@ -16,49 +17,6 @@ char* to_string(int input) {
     return output;
 }
 
-/*
- * reads characters from a filestream until EOF, space, or newline
- * params:  input - filestream to read from
- *          space - 1: allow, 0: deny
- *          newline - 1: allow, 0: replace
- * returns: string ending with a newline 
- *          (replacing newline with a null terminator),
- *          null if error encountered
- */
-char* read_line(FILE* input, int space, int newline) {
-    int size = LINE_BUFF;
-    char* result = (char*)malloc(sizeof(char) * size);
-    int position = 0;
-    int i = 0;
-    while(1) {
-        i = fgetc(input);
-        if(i == EOF || (!space && i == ' ')) {
-            free(result);
-            return NULL;
-        }
-        
-        if(!newline && i == '\n') {
-            result[position] = '\0';
-            return result;
-        } else if(newline && i == '\n') {
-            result[position] = (char)i;
-            if(position > size - 1) {
-                size *= 2;
-                result = (char*)realloc(result, sizeof(char) * size);
-            }
-            result[position + 1] = '\0';
-            return result;
-        }
-       
-        result[position++] = (char)i;
-
-        if(position > size - 1) {
-            size *= 2;
-            result = (char*)realloc(result, sizeof(char) * size);
-        }
-    }
-}
-
 /*
  * concatenates the given string to the output string 
  * and frees the added string
@@ -114,3 +72,65 @@ int is_all_num(char* input) {
     
     return 1;
 }
+
+/*
+ * reads a positive number from the environment
+ * params:  name - environment variable to read
+ *          fallback - value to use if unset or invalid
+ * returns: value of the variable, fallback if unset or invalid
+ */
+int env_number(char* name, int fallback) {
+    char* value = getenv(name);
+    if(!value || !*value || !is_all_num(value) || strlen(value) > 9) {
+        return fallback;
+    }
+
+    return atoi(value);
+}
+
+/*
+ * writes the protocol id of a player, A to Z then AA to ZZ
+ * params:  id - index of the player
+ *          name - buffer of at least ID_SIZE to write to
+ * returns: name
+ */
+char* player_name(int id, char* name) {
+    int length = 0;
+    if(id >= ID_LETTERS) {
+        name[length++] = (char)(id / ID_LETTERS - 1 + TOCHAR);
+    }
+    name[length++] = (char)(id % ID_LETTERS + TOCHAR);
+    name[length] = '\0';
+    return name;
+}
+
+/*
+ * reads a protocol id written by player_name
+ * params:  name - letters of the id, need not be terminated
+ *          length - number of letters
+ * returns: ERR if not a valid id,
+ *          index of the player otherwise
+ */
+int player_id(char* name, int length) {
+    if(length < 1 || length > ID_SIZE - 1) {
+        return ERR;
+    }
+    int id = 0;
+    for(int i = 0; i < length; i++) {
+        if(name[i] < TOCHAR || name[i] >= TOCHAR + ID_LETTERS) {
+            return ERR;
+        }
+        id = id * ID_LETTERS + (name[i] - TOCHAR + 1);
+    }
+    return id - 1;
+}
+
+/*
+ * reads the monotonic clock, unaffected by changes to the system time
+ * returns: microseconds since an arbitrary fixed point
+ */
+long long time_usec(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
@@ -3,6 +3,7 @@
 
 #include <stdio.h>
 #include "card.h"
+#include "arena.h"
 
 // pipe size
 #define FD_SIZE 2
@@ -13,31 +14,40 @@
 #define LINE_BUFF 50
 // number of types of tokens
 #define TOKEN_SIZE 4
-// maximum number of players
-#define MAX_PLAYERS 26
-// converting int to char (e.g. 0 -> 'A')
+// maximum number of players, one for every id from A to ZZ
+#define MAX_PLAYERS 702
+// first letter of player ids (e.g. 0 -> "A", 26 -> "AA")
 #define TOCHAR 65
+// number of letters player ids are written with
+#define ID_LETTERS 26
+// size of a player id, two letters and a terminator
+#define ID_SIZE 3
+// size of each block of the per turn arena
+#define TURN_BLOCK 4096
 
 // struct containing information relevant to the game
 // not all fields will be used by hub or player
 // e.g. pID is irrelevant for hub, hubStack will hold cards not in the game,
-// numPoints will either be the winning amount or the amount currently owned
+// numPoints will either be the winning amount or the amount currently owned,
+// arena holds message memory and is reset every turn,
+// table holds every card of the deck once, the stacks of the hub share it
+// and so does the stack of a player once the hub sends it the table
 typedef struct {
     int pID;
     int pCount;
     int numPoints;
     Stack stack;
     Stack hubStack;
+    CardTable table;
     int discount[TOKEN_SIZE];
     int tokens[TOKEN_SIZE];
     int ownedTokens[TOKEN_SIZE];
     int wild;
+    Arena* arena;
 } Game;
 
 char* to_string(int input);
 
-char* read_line(FILE* input, int space, int newline);
-
 void concat(char* input1, char* input2);
 
 void charcat(char* input1, int position, char input2);
@@ -46,5 +56,13 @@ int has_element(int* array, int len, int element);
 
 int is_all_num(char* input);
 
+int env_number(char* name, int fallback);
+
+long long time_usec(void);
+
+char* player_name(int id, char* name);
+
+int player_id(char* name, int length);
+
 #endif
 
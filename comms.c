@@ -1,72 +1,72 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#include <limits.h>
 #include "err.h"
 #include "card.h"
 #include "comms.h"
 #include "common.h"
 #include "signalHandler.h"
 
-/*
- * adds token information to string
- * params:  output - string to concatenate to
- *          card - struct containing information to convert
- */
-void add_token_info(char* output, Card card) {
-    for(int i = PURPLE; i < CARD_SIZE; i++) {
-        concat(output, to_string(card[i]));
-        if(i < CARD_SIZE - 1) {
-            strcat(output, ",");
-        }
-    }
-}
-
 /*
  * encodes a message and saves it into the given output
  * params:  msg - struct containing message details
- *          output - string containing encoded message
+ *          arena - arena to allocate the encoded message from
  * returns: NULL if invalid contents,
  *          string containing encoded message otherwise
  */
-char* encode_hub(Msg* msg) {
-    char* output = (char*)malloc(sizeof(char) * LINE_BUFF);
+char* encode_hub(Msg* msg, Arena* arena) {
+    char* output = (char*)arena_alloc(arena, sizeof(char) * MSG_SIZE);
+    char name[ID_SIZE];
     switch(msg->type) {
         case EOG:
             strcpy(output, "eog");
             break;
-        case DOWHAT:
-            strcpy(output, "dowhat");
+        case DOWHAT: // the budget is only sent to hubs asked to keep one
+            if(msg->moveBudget || msg->gameBudget) {
+                snprintf(output, MSG_SIZE, "dowhat%d,%d", msg->moveBudget,
+                        msg->gameBudget);
+            } else {
+                strcpy(output, "dowhat");
+            }
             break;
         case TOKENS:
-            strcpy(output, "tokens");
-            concat(output, to_string(msg->tokens));
+            snprintf(output, MSG_SIZE, "tokens%d", msg->tokens);
+            break;
+        case CARD:
+            snprintf(output, MSG_SIZE, "card%c:%d:%d,%d,%d,%d", 
+                    (char)msg->info[COLOR], msg->info[POINTS],
+                    msg->info[PURPLE], msg->info[BROWN], 
+                    msg->info[YELLOW], msg->info[RED]);
             break;
         case NEWCARD:
-            strcpy(output, "newcard");
-            concat(output, card_to_string(msg->info));
+            if(!msg->info[COLOR]) { // interned, the players have the card
+                snprintf(output, MSG_SIZE, "newcard%d", msg->card);
+                break;
+            }
+            snprintf(output, MSG_SIZE, "newcard%c:%d:%d,%d,%d,%d", 
+                    (char)msg->info[COLOR], msg->info[POINTS],
+                    msg->info[PURPLE], msg->info[BROWN], 
+                    msg->info[YELLOW], msg->info[RED]);
             break;
         case PURCHASED:
-            strcpy(output, "purchased"); 
-            charcat(output, strlen("purchased"), msg->player);
-            strcat(output, ":");
-            concat(output, to_string(msg->card));
-            strcat(output, ":");
-            add_token_info(output, msg->info);
-            strcat(output, ",");   
-            concat(output, to_string(msg->wild));
+            snprintf(output, MSG_SIZE, "purchased%s:%d:%d,%d,%d,%d,%d", 
+                    player_name(msg->player, name), msg->card, 
+                    msg->info[PURPLE], msg->info[BROWN], 
+                    msg->info[YELLOW], msg->info[RED], msg->wild);
             break;
         case WILD:
-            strcpy(output, "wild");
-            charcat(output, strlen("wild"), msg->player);
+            snprintf(output, MSG_SIZE, "wild%s", 
+                    player_name(msg->player, name));
             break;
         case TOOK:
-            strcpy(output, "took");
-            charcat(output, strlen("took"), msg->player);
-            strcat(output, ":");
-            add_token_info(output, msg->info);
+            snprintf(output, MSG_SIZE, "took%s:%d,%d,%d,%d", 
+                    player_name(msg->player, name),
+                    msg->info[PURPLE], msg->info[BROWN], 
+                    msg->info[YELLOW], msg->info[RED]);
             break;
         default:
-            free(output);
 #ifdef TEST
             fprintf(stderr, "invalid message\n");
 #endif
@@ -79,31 +79,23 @@ char* encode_hub(Msg* msg) {
 /*
  * encodes a message and saves it into the given output
  * params:  msg - struct containing message details
- *          output - string containing encoded message
+ *          arena - arena to allocate the encoded message from
  * returns: NULL if invalid contents,
  *          string containing encoded message otherwise
  */
-char* encode_player(Msg* msg) {
-    char* output = (char*)malloc(sizeof(char) * LINE_BUFF);
+char* encode_player(Msg* msg, Arena* arena) {
+    char* output = (char*)arena_alloc(arena, sizeof(char) * MSG_SIZE);
+    output[0] = '\0';
     switch(msg->type) {
         case PURCHASE:
-            strcpy(output, "purchase");
-            concat(output, to_string(msg->card));
-            strcat(output, ":");
-            for(int i = PURPLE; i < CARD_SIZE; i++) {
-                concat(output, to_string(msg->info[i]));
-                strcat(output, ",");   
-            }
-            concat(output, to_string(msg->wild));
+            snprintf(output, MSG_SIZE, "purchase%d:%d,%d,%d,%d,%d", 
+                    msg->card, msg->info[PURPLE], msg->info[BROWN], 
+                    msg->info[YELLOW], msg->info[RED], msg->wild);
             break;
         case TAKE:
-            strcpy(output, "take");
-            for(int i = 0; i < TOKEN_SIZE; i++) {
-                concat(output, to_string(msg->info[i + 2]));
-                if(i < TOKEN_SIZE - 1) {
-                    strcat(output, ",");
-                }
-            }
+            snprintf(output, MSG_SIZE, "take%d,%d,%d,%d", 
+                    msg->info[PURPLE], msg->info[BROWN], 
+                    msg->info[YELLOW], msg->info[RED]);
             break;
         case WILD:
             strcpy(output, "wild");
@@ -116,7 +108,112 @@ char* encode_player(Msg* msg) {
 }
 
 /*
- * decodes a message from the hub and saves it to the given message struct
+ * consumes the given text if the input continues with it
+ * params:  cursor - position in the input, advanced past a match
+ *          text - text expected at the cursor
+ * returns: 1 if matched,
+ *          0 otherwise
+ */
+int take_text(char** cursor, char* text) {
+    int length = (int)strlen(text);
+    if(strncmp(*cursor, text, length)) {
+        return 0;
+    }
+
+    *cursor += length;
+    return 1;
+}
+
+/*
+ * consumes a single character of any value
+ * params:  cursor - position in the input, advanced past a match
+ *          output - where to save the character
+ * returns: 1 if a character was consumed,
+ *          0 at the end of the input
+ */
+int take_char(char** cursor, char* output) {
+    if(!**cursor) {
+        return 0;
+    }
+
+    *output = *(*cursor)++;
+    return 1;
+}
+
+/*
+ * consumes a player id of one or more capital letters
+ * params:  cursor - position in the input, advanced past a match
+ *          output - where to save the index of the player
+ * returns: 1 if a valid id was consumed,
+ *          0 otherwise
+ */
+int take_id(char** cursor, int* output) {
+    int length = 0;
+    while(isupper((int)(*cursor)[length])) {
+        length++;
+    }
+    int id = player_id(*cursor, length);
+    if(id == ERR) {
+        return 0;
+    }
+
+    *output = id;
+    *cursor += length;
+    return 1;
+}
+
+/*
+ * consumes a signed decimal integer
+ * params:  cursor - position in the input, advanced past a match
+ *          output - where to save the integer
+ * returns: 1 if an integer was consumed,
+ *          0 if there are no digits or the integer overflows
+ */
+int take_int(char** cursor, int* output) {
+    char* position = *cursor;
+    int negative = *position == '-';
+    if(*position == '-' || *position == '+') {
+        position++;
+    }
+
+    if(!isdigit((int)*position)) {
+        return 0;
+    }
+
+    long value = 0;
+    while(isdigit((int)*position)) {
+        value = value * 10 + (*position++ - '0');
+        if(value > INT_MAX) {
+            return 0;
+        }
+    }
+
+    *output = (int)(negative ? -value : value);
+    *cursor = position;
+    return 1;
+}
+
+/*
+ * consumes a comma separated list of integers
+ * params:  cursor - position in the input, advanced past a match
+ *          output - where to save the integers
+ *          count - number of integers expected
+ * returns: 1 if all integers were consumed,
+ *          0 otherwise
+ */
+int take_list(char** cursor, int* output, int count) {
+    for(int i = 0; i < count; i++) {
+        if((i && !take_text(cursor, ",")) || !take_int(cursor, &output[i])) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * decodes a message from the hub and saves it to the given message struct,
+ * the input is parsed in place and is not modified
  * params:  msg - struct to save message details to
  *          input - string containing message to decode
  * returns: the type of message received,
@@ -126,64 +223,93 @@ Comm decode_hub_msg(Msg* msg, char* input) {
     if(!input) {
         return ERR;
     }
-    char player, color;
-    char end = '\0';
-    int tokens, points, purple, brown, yellow, red, wild, card;
+    char color;
+    int player;
+    int values[TOKEN_SIZE + 1];
+    int number;
+    char* cursor = input;
     if(strcmp(input, "eog") == 0) {
         msg->type = EOG;
     } else if(strcmp(input, "dowhat") == OK) {
         msg->type = DOWHAT;
-    } else if(sscanf(input, "wild%c%c", &player, &end) == 1 && !end) {
+        msg->moveBudget = 0;
+        msg->gameBudget = 0;
+    } else if((cursor = input, take_text(&cursor, "dowhat")) && 
+            take_list(&cursor, values, 2) && !*cursor &&
+            values[0] >= 0 && values[1] >= 0) {
+        msg->type = DOWHAT;
+        msg->moveBudget = values[0];
+        msg->gameBudget = values[1];
+    } else if((cursor = input, take_text(&cursor, "wild")) && 
+            take_id(&cursor, &player) && !*cursor) {
         msg->type = WILD;
         msg->player = player;
-    } else if(sscanf(input, "tokens%d%c", &tokens, &end) == 1 && !end) {
+    } else if((cursor = input, take_text(&cursor, "tokens")) && 
+            take_int(&cursor, &number) && !*cursor) {
         msg->type = TOKENS;
-        msg->tokens = tokens;
+        msg->tokens = number;
+    } else if((cursor = input, take_text(&cursor, "newcard")) && 
+            take_char(&cursor, &color) && take_text(&cursor, ":") &&
+            take_int(&cursor, &number) && take_text(&cursor, ":") &&
+            take_list(&cursor, values, TOKEN_SIZE) && !*cursor) {
+        msg->type = NEWCARD;
+        save_info(msg->info, color, number, 
+                values[0], values[1], values[2], values[3]);
+    } else if((cursor = input, take_text(&cursor, "newcard")) && 
+            take_int(&cursor, &number) && !*cursor) {
+        msg->type = NEWCARD;
+        msg->card = number;
+        save_info(msg->info, (char)0, 0, 0, 0, 0, 0);
+    } else if((cursor = input, take_text(&cursor, "card")) && 
+            take_char(&cursor, &color) && take_text(&cursor, ":") &&
+            take_int(&cursor, &number) && take_text(&cursor, ":") &&
+            take_list(&cursor, values, TOKEN_SIZE) && !*cursor) {
+        msg->type = CARD;
+        save_info(msg->info, color, number, 
+                values[0], values[1], values[2], values[3]);
+    } else if((cursor = input, take_text(&cursor, "purchased")) && 
+            take_id(&cursor, &player) && take_text(&cursor, ":") &&
+            take_int(&cursor, &number) && take_text(&cursor, ":") &&
+            take_list(&cursor, values, TOKEN_SIZE + 1) && !*cursor) {
+        msg->type = PURCHASED;
+        msg->player = player;
+        msg->card = number;
+        save_info(msg->info, (char)0, 0, 
+                values[0], values[1], values[2], values[3]);
+        msg->wild = values[TOKEN_SIZE];
+    } else if((cursor = input, take_text(&cursor, "took")) && 
+            take_id(&cursor, &player) && take_text(&cursor, ":") &&
+            take_list(&cursor, values, TOKEN_SIZE) && !*cursor) {
+        msg->type = TOOK;
+        msg->player = player;
+        save_info(msg->info, (char)0, 0, 
+                values[0], values[1], values[2], values[3]);
     } else {
-        if(sscanf(input, "newcard%c:%d:%d,%d,%d,%d,%c", &color, &points, 
-                &purple, &brown, &yellow, &red, &end) == 6 && !end) {
-            msg->type = NEWCARD;
-            save_info(msg->info, color, points, purple, brown, yellow, red);
-        } else if(sscanf(input, "purchased%c:%d:%d,%d,%d,%d,%d%c", &player, 
-                &card, &purple, &brown, &yellow, &red, &wild, &end) == 7 && 
-                !end) {
-            msg->type = PURCHASED;
-            msg->player = player;
-            msg->card = card;
-            save_info(msg->info, (char)0, 0, purple, brown, yellow, red);
-            msg->wild = wild;
-        } else if(sscanf(input, "took%c:%d,%d,%d,%d%c", &player, 
-                &purple, &brown, &yellow, &red, &end) == 5 && !end) {
-            msg->type = TOOK;
-            msg->player = player;
-            save_info(msg->info, (char)0, 0, purple, brown, yellow, red);
-        } else {
 #ifdef TEST
-            fprintf(stderr, "invalid message: %s\n", input);
+        fprintf(stderr, "invalid message: %s\n", input);
 #endif
-            free(input);
-            return ERR;
-        }
+        return ERR;
     }
     
 #ifdef VERBOSE 
     fprintf(stderr, "decode:[%d] hub=%s\n", msg->type, input);
 #endif
 
-    free(input);
     return msg->type;
 }
 
 /*
- * decodes a message from a player and saves it to the given message struct
+ * decodes a message from a player and saves it to the given message struct,
+ * the input is parsed in place and is not modified
  * params:  msg - struct to save message details to
  *          input - string containing message to decode
  * returns: the type of message received,
  *          ERR if invalid contents
  */
 Comm decode_player_msg(Msg* msg, char* input) {
-    int card, purple, brown, yellow, red, wild;
-    char end = '\0';
+    int values[TOKEN_SIZE + 1];
+    int card;
+    char* cursor = input;
 
 #ifdef TEST
     fprintf(stderr, "decode:\tplayer=%s\n", input);
@@ -191,24 +317,110 @@ Comm decode_player_msg(Msg* msg, char* input) {
 
     if(strcmp(input, "wild") == OK) {
         msg->type = WILD;
-    } else if(sscanf(input, "purchase%d:%d,%d,%d,%d,%d%c", &card, 
-            &purple, &brown, &yellow, &red, &wild, &end) == 6 && !end) {
+    } else if((cursor = input, take_text(&cursor, "purchase")) && 
+            take_int(&cursor, &card) && take_text(&cursor, ":") &&
+            take_list(&cursor, values, TOKEN_SIZE + 1) && !*cursor) {
         msg->type = PURCHASE;
-        save_info(msg->info, (char)0, 0, purple, brown, yellow, red);
-        msg->wild = wild;
+        save_info(msg->info, (char)0, 0, 
+                values[0], values[1], values[2], values[3]);
+        msg->wild = values[TOKEN_SIZE];
         msg->card = card;
-    } else if(sscanf(input, "take%d,%d,%d,%d%c", 
-            &purple, &brown, &yellow, &red, &end) == 4 && !end) {
+    } else if((cursor = input, take_text(&cursor, "take")) && 
+            take_list(&cursor, values, TOKEN_SIZE) && !*cursor) {
         msg->type = TAKE;
-        save_info(msg->info, (char)0, 0, purple, brown, yellow, red);
+        save_info(msg->info, (char)0, 0, 
+                values[0], values[1], values[2], values[3]);
     } else {
 #ifdef TEST
         fprintf(stderr, "invalid message: %s\n", input);
 #endif
-        free(input);
         return ERR;
     }
 
-    free(input);
+    return msg->type;
+}
+
+/*
+ * passes a hub message to a player without encoding it, 
+ * msg is left as decode_hub_msg would leave it after decoding the
+ * encoded source
+ * params:  msg - struct to save message contents to
+ *          source - message as built by the hub
+ * returns: ERR if the hub could not have encoded the message,
+ *          type of message otherwise
+ */
+Comm copy_hub_msg(Msg* msg, Msg* source) {
+    switch(source->type) {
+        case EOG:
+            break;
+        case DOWHAT:
+            msg->moveBudget = source->moveBudget;
+            msg->gameBudget = source->gameBudget;
+            break;
+        case WILD:
+            msg->player = source->player;
+            break;
+        case TOKENS:
+            msg->tokens = source->tokens;
+            break;
+        case NEWCARD:
+            msg->card = source->card;
+            memcpy(msg->info, source->info, sizeof(int) * CARD_SIZE);
+            break;
+        case CARD:
+            memcpy(msg->info, source->info, sizeof(int) * CARD_SIZE);
+            break;
+        case PURCHASED:
+            msg->player = source->player;
+            msg->card = source->card;
+            msg->wild = source->wild;
+            save_info(msg->info, (char)0, 0, 
+                    source->info[PURPLE], source->info[BROWN], 
+                    source->info[YELLOW], source->info[RED]);
+            break;
+        case TOOK:
+            msg->player = source->player;
+            save_info(msg->info, (char)0, 0, 
+                    source->info[PURPLE], source->info[BROWN], 
+                    source->info[YELLOW], source->info[RED]);
+            break;
+        default:
+            return (Comm)ERR;
+    }
+    msg->type = source->type;
+
+    return msg->type;
+}
+
+/*
+ * passes a player message to the hub without encoding it, 
+ * msg is left as decode_player_msg would leave it after decoding the
+ * encoded source
+ * params:  msg - struct to save message contents to
+ *          source - message as built by the player
+ * returns: ERR if the player could not have encoded the message,
+ *          type of message otherwise
+ */
+Comm copy_player_msg(Msg* msg, Msg* source) {
+    switch(source->type) {
+        case WILD:
+            break;
+        case PURCHASE:
+            msg->card = source->card;
+            msg->wild = source->wild;
+            save_info(msg->info, (char)0, 0, 
+                    source->info[PURPLE], source->info[BROWN], 
+                    source->info[YELLOW], source->info[RED]);
+            break;
+        case TAKE:
+            save_info(msg->info, (char)0, 0, 
+                    source->info[PURPLE], source->info[BROWN], 
+                    source->info[YELLOW], source->info[RED]);
+            break;
+        default:
+            return (Comm)ERR;
+    }
+    msg->type = source->type;
+
     return msg->type;
 }
@@ -3,6 +3,10 @@
 
 #include "err.h"
 #include "card.h"
+#include "arena.h"
+
+// maximum size of an encoded message
+#define MSG_SIZE 128
 
 // message types sent between player and hub
 typedef enum {
@@ -14,27 +18,39 @@ typedef enum {
     TOOK,
     PURCHASE,
     TAKE,
-    WILD
+    WILD,
+    CARD
 } Comm;
 
 // deconstructed message between hub and player, 
 // message will be encoded/decoded depending on type,
-// not all fields will be used depending on type
+// player is the index of the player, sent as its letter id,
+// not all fields will be used depending on type,
+// a dowhat carries the milliseconds the player has left for the move and 
+// for the game, 0 if the hub set no such budget,
+// a newcard or purchased names its card by its id in the card table
+// when the hub interns cards, a newcard then has no color in info
 typedef struct {
     Comm type;
-    char player;
+    int player;
     int tokens;
     Card info;
     int wild;
     int card;
+    int moveBudget;
+    int gameBudget;
 } Msg;
 
-char* encode_hub(Msg* msg);
+char* encode_hub(Msg* msg, Arena* arena);
 
-char* encode_player(Msg* msg);
+char* encode_player(Msg* msg, Arena* arena);
 
 Comm decode_hub_msg(Msg* msg, char* input);
 
 Comm decode_player_msg(Msg* msg, char* input);
 
+Comm copy_hub_msg(Msg* msg, Msg* source);
+
+Comm copy_player_msg(Msg* msg, Msg* source);
+
 #endif
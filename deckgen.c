@@ -0,0 +1,265 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+#include "err.h"
+#include "card.h"
+#include "rng.h"
+
+// most values a distribution can give, so 0 to MAX_WEIGHTS - 1
+#define MAX_WEIGHTS 64
+// size of the output buffer, cards are written out once it fills
+#define DECKGEN_BUFFER (1 << 20)
+// longest text card, color, points and 4 costs of up to 10 digits each
+#define CARD_TEXT 72
+// largest total weight drawn through a lookup table instead of a search
+#define DRAW_TABLE 4096
+// colors in the order their weights are given
+#define DECK_COLORS "PBYR"
+
+// weights of the values a field can take, value i has weight weights[i],
+// the weights add up to at most INT_MAX, small totals also get a table 
+// giving the value for every pick so drawing does not branch
+typedef struct {
+    int count;
+    int total;
+    int weights[MAX_WEIGHTS];
+    unsigned char table[DRAW_TABLE];
+} Distribution;
+
+// output settings and the distribution of every field
+typedef struct {
+    uint64_t seed;
+    int binary;
+    Distribution colors;
+    Distribution points;
+    Distribution costs;
+} Generator;
+
+/*
+ * reads a distribution given as weights separated by colons, "w0:w1:..."
+ * params:  input - weights to read
+ *          distribution - where to save the weights
+ *          count - number of weights required, 0 for any number
+ * returns: ERR if the weights are invalid or all zero,
+ *          OK otherwise
+ */
+Error parse_distribution(char* input, Distribution* distribution, 
+        int count) {
+    distribution->count = 0;
+    distribution->total = 0;
+    char* next = input;
+    do {
+        char* end;
+        long weight = strtol(next, &end, 10);
+        if(end == next || weight < 0 || 
+                weight > INT_MAX - distribution->total ||
+                (*end && *end != ':') || 
+                distribution->count == MAX_WEIGHTS) {
+            return ERR;
+        }
+        distribution->weights[distribution->count++] = (int)weight;
+        distribution->total += (int)weight;
+        next = end + 1;
+        if(!*end) {
+            break;
+        }
+    } while(1);
+
+    if(!distribution->total || (count && distribution->count != count)) {
+        return ERR;
+    }
+
+    if(distribution->total <= DRAW_TABLE) {
+        int pick = 0;
+        for(int i = 0; i < distribution->count; i++) {
+            memset(distribution->table + pick, i, distribution->weights[i]);
+            pick += distribution->weights[i];
+        }
+    }
+
+    return OK;
+}
+
+/*
+ * draws a value from a distribution
+ * params:  distribution - weights of the values
+ *          rng - generator to draw with
+ * returns: value from 0 to the number of weights - 1
+ */
+int draw(Distribution* distribution, Rng* rng) {
+    int pick = rng_range(rng, distribution->total);
+    if(distribution->total <= DRAW_TABLE) {
+        return distribution->table[pick];
+    }
+
+    int value = 0;
+    while(pick >= distribution->weights[value]) {
+        pick -= distribution->weights[value++];
+    }
+
+    return value;
+}
+
+/*
+ * writes a number in decimal
+ * params:  output - where to write, must have room for 10 digits
+ *          number - non negative number to write
+ * returns: position after the number
+ */
+char* put_number(char* output, int number) {
+    char digits[10];
+    int length = 0;
+    do {
+        digits[length++] = (char)('0' + number % 10);
+        number /= 10;
+    } while(number);
+    while(length) {
+        *output++ = digits[--length];
+    }
+
+    return output;
+}
+
+/*
+ * writes a card in the text deck format, color:points:p,b,y,r
+ * params:  output - where to write, must have room for CARD_TEXT bytes
+ *          card - fields of the card
+ * returns: position after the card
+ */
+char* put_text(char* output, int32_t* card) {
+    *output++ = (char)card[COLOR];
+    *output++ = ':';
+    output = put_number(output, card[POINTS]);
+    *output++ = ':';
+    for(int i = PURPLE; i < CARD_SIZE; i++) {
+        output = put_number(output, card[i]);
+        *output++ = i < RED ? ',' : '\n';
+    }
+
+    return output;
+}
+
+/*
+ * writes the cards one at a time through a fixed buffer, 
+ * so memory stays the same whatever the size of the deck
+ * params:  generator - output settings and distributions
+ *          cards - number of cards to write
+ *          output - file to write to
+ * returns: E_DECKIO if writing failed,
+ *          OK otherwise
+ */
+Error generate(Generator* generator, long long cards, FILE* output) {
+    Rng rng;
+    rng_seed(&rng, generator->seed);
+    char* buffer = (char*)malloc(DECKGEN_BUFFER);
+    int used = 0;
+    if(generator->binary) {
+        memcpy(buffer, DECK_MAGIC, strlen(DECK_MAGIC));
+        used = strlen(DECK_MAGIC);
+    }
+
+    for(long long i = 0; i < cards; i++) {
+        if(used > DECKGEN_BUFFER - CARD_TEXT) {
+            if(fwrite(buffer, 1, used, output) != (size_t)used) {
+                break;
+            }
+            used = 0;
+        }
+
+        int32_t card[CARD_SIZE];
+        card[COLOR] = DECK_COLORS[draw(&generator->colors, &rng)];
+        card[POINTS] = draw(&generator->points, &rng);
+        for(int j = PURPLE; j < CARD_SIZE; j++) {
+            card[j] = draw(&generator->costs, &rng);
+        }
+
+        if(generator->binary) {
+            memcpy(buffer + used, card, sizeof(card));
+            used += sizeof(card);
+        } else {
+            used = (int)(put_text(buffer + used, card) - buffer);
+        }
+    }
+    fwrite(buffer, 1, used, output);
+    free(buffer);
+
+    return fflush(output) || ferror(output) ? E_DECKIO : OK;
+}
+
+/*
+ * prints usage of deckgen to stderr
+ * returns: E_ARGC
+ */
+Error usage(void) {
+    fprintf(stderr, "Usage: deckgen [-b] [-s seed] [-c colors] [-p points] "
+            "[-t costs] cards [file]\n");
+    return E_ARGC;
+}
+
+/*
+ * writes a deck of random cards to a file or stdout, 
+ * the same seed and settings always give the same deck
+ */
+int main(int argc, char** argv) {
+    Generator generator;
+    generator.seed = 0;
+    generator.binary = 0;
+    parse_distribution("1:1:1:1", &generator.colors, 4);
+    parse_distribution("0:3:2:1", &generator.points, 0);
+    parse_distribution("4:3:2:1", &generator.costs, 0);
+
+    int option;
+    char* end;
+    opterr = 0;
+    while((option = getopt(argc, argv, "bs:c:p:t:")) != -1) {
+        Error err = OK;
+        switch(option) {
+            case 'b':
+                generator.binary = 1;
+                break;
+            case 's':
+                generator.seed = strtoull(optarg, &end, 10);
+                err = *end || end == optarg ? ERR : OK;
+                break;
+            case 'c':
+                err = parse_distribution(optarg, &generator.colors, 4);
+                break;
+            case 'p':
+                err = parse_distribution(optarg, &generator.points, 0);
+                break;
+            case 't':
+                err = parse_distribution(optarg, &generator.costs, 0);
+                break;
+            default:
+                err = ERR;
+        }
+        if(err) {
+            return usage();
+        }
+    }
+
+    long long cards = 0;
+    if(argc - optind < 1 || argc - optind > 2 || 
+            (cards = strtoll(argv[optind], &end, 10)) < 1 || *end) {
+        return usage();
+    }
+
+    FILE* output = stdout;
+    if(argc - optind == 2 && !(output = fopen(argv[optind + 1], "w"))) {
+        fprintf(stderr, "Cannot write %s\n", argv[optind + 1]);
+        return E_DECKIO;
+    }
+
+    Error err = generate(&generator, cards, output);
+    if(output != stdout) {
+        err = fclose(output) ? E_DECKIO : err;
+    }
+    if(err) {
+        fprintf(stderr, "Cannot write deck\n");
+    }
+
+    return err;
+}
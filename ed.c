@@ -6,6 +6,7 @@
 #include "err.h"
 #include "common.h"
 #include "playerCommon.h"
+#include "plugin.h"
 #include "comms.h"
 #include "card.h"
 #include "token.h"
@@ -14,7 +15,8 @@
 /*
  * checks if player can ALMOST afford the card with their owned tokens
  * mainly for ed if the player cant find a card it can buy outright
- * params:  card - card to purchase
+ * params:  arena - arena to allocate the result from
+ *          card - card to purchase
  *          discount - discount from owned cards
  *          tokens - players owned tokens
  *          tokenOrder - order in which to check for tokens
@@ -22,23 +24,22 @@
  * returns: NULL if cannot ALMOST afford,
  *          int array of tokens used otherwise
  */
-int* can_almost_afford(Card card, int* discount, int* tokens, 
+int* can_almost_afford(Arena* arena, Card card, int* discount, int* tokens, 
         int* tokenOrder, int wild) {
     int usedWild = 0;
     int totalDebt = 0; // total number of tokens owed
-    int* debt = (int*)calloc(TOKEN_SIZE, sizeof(int)); // which tokens owed
+    int* debt = (int*)arena_alloc(arena, TOKEN_SIZE * sizeof(int)); 
+    memset(debt, 0, TOKEN_SIZE * sizeof(int)); // which tokens owed
     for(int i = 0; i < TOKEN_SIZE; i++) {
         int cost = card[tokenOrder[i] + 2] - discount[tokenOrder[i]];
         int sum = cost - tokens[tokenOrder[i]] + wild - usedWild; // balance 
         if(sum > 1) { // greater than a single draw
-            free(debt);
             return NULL;
         }
 
         if(sum == 1) { // can be covered from a single draw
             totalDebt++;
             if(totalDebt > 3) { // debt already exceeded
-                free(debt);
                 return NULL;
             }
 
@@ -111,7 +112,7 @@ int choose_card(Game* game, Opponent* opponents) {
     int chosenCard = -100; // out of bounds, no chance of valid card
     for(int i = 0; i < validCardNum; i++) { // find card this player can buy
         if(can_afford(game->stack.deck[validCards[i]], game->discount, 
-                game->tokens, game->wild) > -1) {
+                game->ownedTokens, game->wild) > -1) {
             chosenCard = validCards[i];
             break;
         }
@@ -137,8 +138,9 @@ int* choose_alternate_card(Game* game, Opponent* opponents, int* tokenOrder) {
             sortedCards, &validCardNum);
     for(int i = 0; i < game->pCount; i++) { // for each player find
         for(int j = 0; j < validCardNum; j++) { // find almost buyable
-            debt = can_almost_afford(game->stack.deck[validCards[i]], 
-                    game->discount, game->tokens, tokenOrder, game->wild);
+            debt = can_almost_afford(game->arena, 
+                    game->stack.deck[validCards[i]], game->discount, 
+                    game->tokens, tokenOrder, game->wild);
             if(debt) { // alternate found 
                 free(sortedCards);
                 free(validCards);
@@ -177,33 +179,37 @@ Msg* ed_move(Game* game, ...) {
             game->tokens[2], game->tokens[3]);
 #endif
 
-    Msg* msg = (Msg*)malloc(sizeof(Msg));
+    Msg* msg = (Msg*)arena_alloc(game->arena, sizeof(Msg));
     int chosenCard = choose_card(game, opponents);
     if(chosenCard > -1) { // valid card found
         msg->type = PURCHASE;
         msg->card = chosenCard;
-        msg->info = (Card)malloc(sizeof(int) * CARD_SIZE);
+        msg->info = (Card)arena_alloc(game->arena,
+                sizeof(int) * CARD_SIZE);
         msg->wild = can_afford(game->stack.deck[chosenCard], game->discount,
                 game->ownedTokens, game->wild);
-        int* usedTokens = get_card_cost(game->discount, game->ownedTokens,
-                game->stack.deck[chosenCard]);
+        int* usedTokens = get_card_cost(game->arena, game->discount,
+                game->ownedTokens, game->wild, game->stack.deck[chosenCard]);
         memcpy(msg->info + 2, usedTokens, sizeof(int) * TOKEN_SIZE);
-        free(usedTokens);
     } else { // no cards are affordable outright by this player
         int tokenOrder[] = {YELLOW - 2, RED - 2, BROWN - 2, PURPLE - 2};
         int* debt = choose_alternate_card(game, opponents, tokenOrder);
-        int* tokens = get_tokens(game->tokens, tokenOrder);
+        for(int i = 0; debt && i < TOKEN_SIZE; i++) {
+            if(debt[i] && game->tokens[i] < 1) { // the bank has run out
+                debt = NULL;
+            }
+        }
+        int* tokens = get_tokens(game->arena, game->tokens, tokenOrder);
         if(debt) {
             msg->type = TAKE;
-            msg->info = (Card)malloc(sizeof(int) * CARD_SIZE);
+            msg->info = (Card)arena_alloc(game->arena,
+                    sizeof(int) * CARD_SIZE);
             memcpy(msg->info + 2, debt, sizeof(int) * TOKEN_SIZE);
-            free(debt);
-            free(tokens);
         } else if(tokens) {
             msg->type = TAKE;
-            msg->info = (Card)malloc(sizeof(int) * CARD_SIZE);
+            msg->info = (Card)arena_alloc(game->arena,
+                    sizeof(int) * CARD_SIZE);
             memcpy(msg->info + 2, tokens, sizeof(int) * TOKEN_SIZE);
-            free(tokens);
         } else {
             msg->type = WILD;
         }
@@ -212,6 +218,10 @@ Msg* ed_move(Game* game, ...) {
     return msg;
 }
 
+#ifdef PLUGIN
+// lets the hub load ed as a plugin, it keeps no state of its own
+Strategy strategy = {PLUGIN_ABI, NULL, &ed_move, NULL, 1};
+#else
 int main(int argc, char** argv) {
     if(argc != 3) {
         perr_msg(E_ARGC, ED);
@@ -236,7 +246,7 @@ int main(int argc, char** argv) {
     int signalList[] = {SIGPIPE};
     init_signal_handler(signalList, 1);
     
-    Error err = play_game(&game, &ed_move);
+    Error err = play_game(&game, &ed_move, 1);
     if(err == UTIL) {
         err = OK;
     }
@@ -245,11 +255,7 @@ int main(int argc, char** argv) {
         err = E_COMMERR;
     }
     
-    if(game.stack.numCards) {
-        shred_deck(game.stack.deck, game.stack.numCards);
-    } else {
-        free(game.stack.deck);
-    }
+    shred_player_game(&game);
 
 #ifdef TEST
     fprintf(stderr, "ed exiting\n");
@@ -258,3 +264,4 @@ int main(int argc, char** argv) {
     perr_msg(err, ED); 
     return err;
 }
+#endif
@@ -9,7 +9,7 @@
  *          ptype - a string representing the type of player
  */
 void perr_msg(Error code, int pType) {
-    char* players[] = {"shenzi", "banzai", "ed"};
+    char* players[] = {"shenzi", "banzai", "ed", "scar"};
     switch(code) {
         case OK:
             return;
@@ -42,8 +42,15 @@ void herr_msg(Error code) {
         case OK:
             return;
         case E_ARGC:
-            fprintf(stderr, "Usage: austerity tokens points "
-                    "deck player player [player ...]\n");
+            fprintf(stderr, "Usage: austerity [-l text|quiet|binary] "
+                    "[-r results] [-m stats] [-a placement] [-C seconds] "
+                    "[-M megabytes] [-z] [-R rounds] [-t milliseconds] "
+                    "[-g milliseconds] [-i] [-u] tokens points deck "
+                    "player player [player ...]\n"
+                    "       austerity [-r results] [-m stats] "
+                    "[-a placement] [-C seconds] [-M megabytes] [-z] "
+                    "[-R rounds] [-t milliseconds] [-g milliseconds] [-i] "
+                    "[-c tables] -s jobs\n");
             break;
         case E_ARGV:
             fprintf(stderr, "Bad argument\n");
@@ -63,6 +70,12 @@ void herr_msg(Error code) {
         case E_PROTOCOL:
             fprintf(stderr, "Protocol error by client\n");
             break;
+        case E_ABORTED:
+            fprintf(stderr, "Game aborted\n");
+            break;
+        case E_TIMEOUT:
+            fprintf(stderr, "Player ran out of time\n");
+            break;
         case E_SIGINT:
             fprintf(stderr, "SIGINT caught\n");
             break;
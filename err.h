@@ -17,6 +17,8 @@ typedef enum {
     E_COMMERR = 6,
     E_DEADPLAYER = 6,
     E_PROTOCOL = 7,
+    E_ABORTED = 8,
+    E_TIMEOUT = 9,
     E_SIGINT = 10,
     UTIL = 42
 } Error;
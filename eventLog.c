@@ -0,0 +1,325 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "err.h"
+#include "common.h"
+#include "eventLog.h"
+
+// game events waiting to be written,
+// formatted by the hub and written out by a separate thread
+typedef struct {
+    LogSink sink;
+    int fd;
+    char* ring;
+    size_t head;        // total bytes ever added
+    size_t tail;        // total bytes ever written
+    int open;
+    int closing;
+    int failed;
+    pthread_t writer;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;   // signalled when events are added
+    pthread_cond_t space;   // signalled when events are written
+} EventLog;
+
+static EventLog eventLog; // zeroed, so the text sink until opened
+
+/*
+ * writes all of the given bytes to the log file descriptor
+ * params:  data - bytes to write
+ *          size - number of bytes to write
+ * returns: ERR if the write fails,
+ *          OK otherwise
+ */
+Error log_write(char* data, size_t size) {
+    while(size > 0) {
+        ssize_t written = write(eventLog.fd, data, size);
+        if(written < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            return ERR;
+        }
+        data += written;
+        size -= (size_t)written;
+    }
+    return OK;
+}
+
+/*
+ * waits up to LOG_LINGER for the ring to fill to a full batch,
+ * assumes the lock is held
+ */
+void log_linger(void) {
+    struct timespec until;
+    clock_gettime(CLOCK_REALTIME, &until);
+    until.tv_nsec += LOG_LINGER * 1000000L;
+    if(until.tv_nsec >= 1000000000L) {
+        until.tv_sec++;
+        until.tv_nsec -= 1000000000L;
+    }
+    while(!eventLog.closing && eventLog.head - eventLog.tail < LOG_BATCH) {
+        if(pthread_cond_timedwait(&eventLog.ready, &eventLog.lock, 
+                &until) == ETIMEDOUT) {
+            break;
+        }
+    }
+}
+
+/*
+ * writer thread, sleeps until events arrive and writes them in batches,
+ * signals are left to the hub thread, which is sent SIGPIPE if stdout closes
+ * params:  arg - unused
+ * returns: NULL
+ */
+void* log_writer(void* arg) {
+    (void)arg;
+    sigset_t all;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, NULL);
+
+    pthread_mutex_lock(&eventLog.lock);
+    while(1) {
+        while(eventLog.head == eventLog.tail && !eventLog.closing) {
+            pthread_cond_wait(&eventLog.ready, &eventLog.lock);
+        }
+        if(eventLog.head == eventLog.tail) {
+            break; // closing and nothing left
+        }
+        log_linger();
+
+        size_t start = eventLog.tail % LOG_RING;
+        size_t size = eventLog.head - eventLog.tail;
+        if(start + size > LOG_RING) { // write up to the wrap
+            size = LOG_RING - start;
+        }
+        pthread_mutex_unlock(&eventLog.lock);
+
+        Error err = eventLog.failed ? ERR : 
+                log_write(eventLog.ring + start, size);
+        int closed = err && errno == EPIPE;
+
+        pthread_mutex_lock(&eventLog.lock);
+        if(err && !eventLog.failed) {
+            eventLog.failed = 1; // keep draining so the hub never blocks
+            if(closed) { // let the hub see it as if it wrote
+                kill(getpid(), SIGPIPE);
+            }
+        }
+        eventLog.tail += size;
+        pthread_cond_broadcast(&eventLog.space);
+    }
+    pthread_mutex_unlock(&eventLog.lock);
+
+    return NULL;
+}
+
+/*
+ * starts logging game events to the given file descriptor,
+ * the quiet sink needs no writer
+ * params:  sink - format of the events
+ *          fd - file descriptor to write events to
+ * returns: UTIL if the writer cannot be started,
+ *          OK otherwise
+ */
+Error log_open(LogSink sink, int fd) {
+    eventLog.sink = sink;
+    eventLog.fd = fd;
+    eventLog.head = 0;
+    eventLog.tail = 0;
+    eventLog.closing = 0;
+    eventLog.failed = 0;
+    if(sink == SINK_QUIET) {
+        return OK;
+    }
+
+    eventLog.ring = (char*)malloc(LOG_RING);
+    if(!eventLog.ring) {
+        return UTIL;
+    }
+    pthread_mutex_init(&eventLog.lock, NULL);
+    pthread_cond_init(&eventLog.ready, NULL);
+    pthread_cond_init(&eventLog.space, NULL);
+    if(pthread_create(&eventLog.writer, NULL, log_writer, NULL)) {
+        free(eventLog.ring);
+        eventLog.ring = NULL;
+        return UTIL;
+    }
+    eventLog.open = 1;
+
+    return OK;
+}
+
+/*
+ * copies an event into the ring, waiting for the writer if it is full
+ * params:  data - bytes of the event
+ *          size - number of bytes in the event
+ */
+void log_add(char* data, size_t size) {
+    if(!eventLog.open) {
+        return;
+    }
+    pthread_mutex_lock(&eventLog.lock);
+    while(LOG_RING - (eventLog.head - eventLog.tail) < size) {
+        pthread_cond_wait(&eventLog.space, &eventLog.lock);
+    }
+
+    size_t start = eventLog.head % LOG_RING;
+    size_t first = size < LOG_RING - start ? size : LOG_RING - start;
+    memcpy(eventLog.ring + start, data, first);
+    memcpy(eventLog.ring, data + first, size - first);
+    eventLog.head += size;
+
+    pthread_cond_signal(&eventLog.ready);
+    pthread_mutex_unlock(&eventLog.lock);
+}
+
+/*
+ * adds an event to the ring in the binary format
+ * params:  type - type of event
+ *          values - values of the event
+ *          count - number of values
+ */
+void log_record(EventType type, int* values, int count) {
+    char record[sizeof(uint16_t) * 2 + sizeof(int32_t) * MAX_PLAYERS];
+    uint16_t header[2] = {(uint16_t)type, (uint16_t)count};
+    memcpy(record, header, sizeof(header));
+    for(int i = 0; i < count; i++) {
+        int32_t value = values[i];
+        memcpy(record + sizeof(header) + i * sizeof(int32_t), &value,
+                sizeof(int32_t));
+    }
+    log_add(record, sizeof(header) + count * sizeof(int32_t));
+}
+
+/*
+ * logs a card being added to the board
+ * params:  card - card that was added
+ */
+void log_card(Card card) {
+    if(eventLog.sink == SINK_BINARY) {
+        int values[] = {card[COLOR], card[POINTS], card[PURPLE], 
+                card[BROWN], card[YELLOW], card[RED]};
+        log_record(EVENT_CARD, values, 6);
+        return;
+    }
+
+    char line[EVENT_SIZE];
+    int size = snprintf(line, EVENT_SIZE, 
+            "New card = Bonus %c, worth %d, costs %d,%d,%d,%d\n",
+            (char)card[COLOR], card[POINTS],
+            card[PURPLE], card[BROWN],
+            card[YELLOW], card[RED]);
+    log_add(line, (size_t)size);
+}
+
+/*
+ * logs a player purchasing a card
+ * params:  player - index of the player
+ *          position - position of the purchased card
+ *          card - tokens used
+ *          wild - wild tokens used
+ */
+void log_purchase(int player, int position, Card card, int wild) {
+    if(eventLog.sink == SINK_BINARY) {
+        int values[] = {player, position, card[PURPLE], card[BROWN], 
+                card[YELLOW], card[RED], wild};
+        log_record(EVENT_PURCHASE, values, 7);
+        return;
+    }
+
+    char name[ID_SIZE];
+    char line[EVENT_SIZE];
+    int size = snprintf(line, EVENT_SIZE, 
+            "Player %s purchased %d using %d,%d,%d,%d,%d\n", 
+            player_name(player, name), position,
+            card[PURPLE], card[BROWN], card[YELLOW], card[RED], wild);
+    log_add(line, (size_t)size);
+}
+
+/*
+ * logs a player taking tokens
+ * params:  player - index of the player
+ *          card - tokens taken
+ */
+void log_drew(int player, Card card) {
+    if(eventLog.sink == SINK_BINARY) {
+        int values[] = {player, card[PURPLE], card[BROWN], 
+                card[YELLOW], card[RED]};
+        log_record(EVENT_DREW, values, 5);
+        return;
+    }
+
+    char name[ID_SIZE];
+    char line[EVENT_SIZE];
+    int size = snprintf(line, EVENT_SIZE, "Player %s drew %d,%d,%d,%d\n", 
+            player_name(player, name), card[PURPLE], card[BROWN], 
+            card[YELLOW], card[RED]);
+    log_add(line, (size_t)size);
+}
+
+/*
+ * logs a player taking a wild
+ * params:  player - index of the player
+ */
+void log_wild(int player) {
+    if(eventLog.sink == SINK_BINARY) {
+        log_record(EVENT_WILD, &player, 1);
+        return;
+    }
+
+    char name[ID_SIZE];
+    char line[EVENT_SIZE];
+    int size = snprintf(line, EVENT_SIZE, "Player %s took a wild\n", 
+            player_name(player, name));
+    log_add(line, (size_t)size);
+}
+
+/*
+ * logs the winners of the game
+ * params:  winners - indicies of the winning players
+ *          count - number of winners
+ */
+void log_winners(int* winners, int count) {
+    if(eventLog.sink == SINK_BINARY) {
+        log_record(EVENT_WINNERS, winners, count);
+        return;
+    }
+
+    char line[EVENT_SIZE + MAX_PLAYERS * ID_SIZE];
+    char name[ID_SIZE];
+    int size = sprintf(line, "Winner(s) ");
+    for(int i = 0; i < count; i++) {
+        size += sprintf(line + size, "%s%s", player_name(winners[i], name), 
+                i < count - 1 ? "," : "");
+    }
+    size += sprintf(line + size, "\n");
+    log_add(line, (size_t)size);
+}
+
+/*
+ * writes out any remaining events and stops the writer
+ */
+void log_close(void) {
+    if(!eventLog.open) {
+        return;
+    }
+    pthread_mutex_lock(&eventLog.lock);
+    eventLog.closing = 1;
+    pthread_cond_signal(&eventLog.ready);
+    pthread_mutex_unlock(&eventLog.lock);
+    pthread_join(eventLog.writer, NULL);
+
+    pthread_mutex_destroy(&eventLog.lock);
+    pthread_cond_destroy(&eventLog.ready);
+    pthread_cond_destroy(&eventLog.space);
+    free(eventLog.ring);
+    eventLog.ring = NULL;
+    eventLog.open = 0;
+}
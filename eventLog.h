@@ -0,0 +1,48 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include "err.h"
+#include "card.h"
+
+// size of the ring buffer events are formatted into
+#define LOG_RING (1 << 20)
+// longest text event, excluding the winners list
+#define EVENT_SIZE 128
+// amount of buffered output worth a write without waiting for more
+#define LOG_BATCH (1 << 16)
+// time the writer waits for a batch to fill, in milliseconds
+#define LOG_LINGER 5
+
+// where game events are written
+typedef enum {
+    SINK_TEXT,
+    SINK_QUIET,
+    SINK_BINARY
+} LogSink;
+
+// types of game events,
+// in the binary sink each event is a record of two 16 bit fields,
+// type and count, followed by count 32 bit values in host byte order
+typedef enum {
+    EVENT_CARD,         // color, points, purple, brown, yellow, red
+    EVENT_PURCHASE,     // player, position, purple, brown, yellow, red, wild
+    EVENT_DREW,         // player, purple, brown, yellow, red
+    EVENT_WILD,         // player
+    EVENT_WINNERS       // player [player ...]
+} EventType;
+
+Error log_open(LogSink sink, int fd);
+
+void log_card(Card card);
+
+void log_purchase(int player, int position, Card card, int wild);
+
+void log_drew(int player, Card card);
+
+void log_wild(int player);
+
+void log_winners(int* winners, int count);
+
+void log_close(void);
+
+#endif
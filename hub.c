@@ -8,7 +8,11 @@
 #include "common.h"
 #include "comms.h"
 #include "hub.h"
+#include "plugin.h"
 #include "signalHandler.h"
+#include "trace.h"
+#include "metrics.h"
+#include "moves.h"
 
 /*
  * checks invocation arguments and saves into session memory
@@ -44,13 +48,17 @@ Error hub_init(char** argv, Game* game) {
 
     game->stack.numCards = 0;
     game->stack.deck = (Deck)malloc(sizeof(Card));
+    game->stack.shared = 1; // dealt from the table
     game->hubStack.numCards = 0;
-    game->hubStack.deck = (Deck)malloc(sizeof(Card));
-    if(read_deck(deckFile, &game->hubStack) != OK) {
-        fclose(deckFile);
+    game->hubStack.deck = NULL;
+    game->table.numCards = 0;
+    game->table.cards = NULL;
+    Error err = read_table(deckFile, &game->table);
+    fclose(deckFile);
+    share_table(&game->table, &game->hubStack);
+    if(err) {
         return E_DECKR;
     }
-    fclose(deckFile);
 
 #ifdef VERBOSE
     print_deck(game->stack.deck, game->stack.numCards);
@@ -60,18 +68,38 @@ Error hub_init(char** argv, Game* game) {
 }
 
 /*
- * sends the message to all players in order
+ * sends the message to all players in order, the message is encoded once
+ * for every player on a pipe and plugins are handed the message directly;
+ * pipes are only flushed at the end of the game or when a player is asked
+ * for a move, so players wake once a turn instead of once a message
  * params:  pCount - number of players to send message to
  *          players - array of players
  *          msg - struct containing message contents
+ *          arena - arena to encode the message in
  * returns: E_DEADPLAYER if player closed pipe unexpectedly
  *          OK otherwise
  */
-Error broadcast(int pCount, Player* players, Msg* msg) {
-    Error err;
+Error broadcast(int pCount, Player* players, Msg* msg, Arena* arena) {
+    uint64_t start = trace_begin();
+    Error err = OK;
+    char* encodedMsg = encode_hub(msg, arena);
+    if(!encodedMsg) {
+        trace_end("broadcast", start);
+        return E_DEADPLAYER;
+    }
+
     for(int i = 0; i < pCount; i++) {
-        err = send_msg(msg, players[i].toChild);
+        Error sent;
+        if(players[i].plugin) { // no encoding needed inside the hub
+            METRIC_ADD(sent, 1);
+            sent = plugin_deliver(players[i].plugin, msg);
+        } else {
+            sent = send_encoded(encodedMsg, players[i].toChild, 
+                    msg->type == EOG);
+        }
+        err = sent ? sent : err;
     }
+    trace_end("broadcast", start);
 
     if(err) {
         return E_DEADPLAYER;
@@ -84,22 +112,42 @@ Error broadcast(int pCount, Player* players, Msg* msg) {
  * TODO send_msg takes the message and pipes it through the given fd
  * params:  msg - message to send
  *          destination - pipe to write to
+ *          arena - arena to encode the message in
  * returns: E_DEADPLAYER if pipe closed unexpectedly
  *          OK otherwise
  */
-Error send_msg(Msg* msg, FILE* destination) {
-    char* encodedMsg = encode_hub(msg);
-    if(!encodedMsg) {
-        return E_PROTOCOL;
-    }
+Error send_msg(Msg* msg, FILE* destination, Arena* arena) {
+    uint64_t start = trace_begin();
+    char* encodedMsg = encode_hub(msg, arena);
+    Error err = encodedMsg ? send_encoded(encodedMsg, destination, 1) : 
+            E_PROTOCOL;
+    trace_end("send_msg", start);
 
+    return err;
+}
+
+/*
+ * pipes an already encoded message through the given fd
+ * params:  encodedMsg - message to send, without the newline
+ *          destination - pipe to write to
+ *          flush - 1: write now, 0: leave in the buffer
+ * returns: E_DEADPLAYER if pipe closed unexpectedly
+ *          OK otherwise
+ */
+Error send_encoded(char* encodedMsg, FILE* destination, int flush) {
 #ifdef TEST
     printf("sending to child: %s\n", encodedMsg);
 #endif
 
     fprintf(destination, "%s\n", encodedMsg);
-    fflush(destination);
-    free(encodedMsg);
+    METRIC_ADD(sent, 1);
+    METRIC_ADD(bytesSent, strlen(encodedMsg) + 1);
+    if(flush) {
+        fflush(destination);
+    }
+    if(ferror(destination)) { // seen here when sigpipe is ignored
+        return E_DEADPLAYER;
+    }
     
     int signal = check_signal();
     if(signal) {
@@ -108,3 +156,51 @@ Error send_msg(Msg* msg, FILE* destination) {
 
     return OK;
 }
+
+/*
+ * checks if the players requested move is legal, a take or purchase is
+ * only legal if legal_moves lists it for the player, so the hub and the
+ * players that search with the generator always agree on what is legal
+ * params:  game - struct containing relevant game information
+ *          state - state of the players
+ *          pID - player making the move
+ *          msg - contents of message to check for validity
+ * returns: ERR if illegal,
+ *          OK otherwise
+ */
+Error valid_move(Game* game, PlayerState* state, int pID, Msg* msg) {
+    if(msg->type == WILD) {
+#ifdef TEST
+        printf("%d requested wild\n", pID);
+#endif
+        return OK;
+    } 
+    
+    Move move = {msg->type, -1, {0}, 0};
+    if(msg->type == TAKE) {
+#ifdef TEST
+        printf("%d requested tokens:%d,%d,%d,%d; have:%d,%d,%d,%d\n", 
+                pID, 
+                msg->info[PURPLE], msg->info[BROWN], msg->info[YELLOW], 
+                msg->info[RED], game->tokens[0], game->tokens[1],
+                game->tokens[2], game->tokens[3]);
+#endif
+    } else if(msg->type == PURCHASE) {
+#ifdef TEST
+        if(msg->card >= 0 && msg->card < game->stack.numCards) {
+            fprintf(stderr, "%d requested card: ", pID);
+            print_card(game->stack.deck[msg->card], msg->card);
+        }
+#endif
+        move.card = msg->card;
+        move.wild = msg->wild;
+    } else {
+        return ERR;
+    }
+    memcpy(move.tokens, msg->info + PURPLE, sizeof(int) * TOKEN_SIZE);
+
+    Move moves[MAX_MOVES];
+    int count = legal_moves(game->tokens, &game->stack, state->discount[pID],
+            state->ownedTokens[pID], state->wild[pID], moves);
+    return find_move(moves, count, &move) < 0 ? ERR : OK;
+}
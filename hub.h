@@ -9,8 +9,22 @@
 
 Error hub_init(char** argv, Game* game);
 
-Error broadcast(int pCount, Player* players, Msg* msg);
+Error broadcast(int pCount, Player* players, Msg* msg, Arena* arena);
 
-Error send_msg(Msg* msg, FILE* destination);
+Error send_msg(Msg* msg, FILE* destination, Arena* arena);
+
+Error send_encoded(char* encodedMsg, FILE* destination, int flush);
+
+Error valid_move(Game* game, PlayerState* state, int pID, Msg* msg);
+
+// turns of a game, defined with the hub itself in austerity.c
+
+void clear_game(Game* game, Session* session);
+
+Error begin_game(Game* game, Session* session);
+
+Error take_move(Game* game, Session* session, char* line);
+
+Error finish_game(Game* game, Session* session, Error err);
 
 #endif
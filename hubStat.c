@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "err.h"
+#include "common.h"
+#include "metrics.h"
+
+// default seconds between samples
+#define DEFAULT_INTERVAL 1.0
+
+/*
+ * copies the counters of a running hub field by field
+ * params:  source - mapped stats file
+ *          copy - where to save the counters
+ */
+void sample(Metrics* source, Metrics* copy) {
+    uint64_t* from = (uint64_t*)&source->started;
+    uint64_t* to = (uint64_t*)&copy->started;
+    size_t fields = (sizeof(Metrics) - offsetof(Metrics, started)) / 
+            sizeof(uint64_t);
+    for(size_t i = 0; i < fields; i++) {
+        to[i] = __atomic_load_n(&from[i], __ATOMIC_RELAXED);
+    }
+    copy->pid = source->pid;
+}
+
+/*
+ * prints a counter with its rate since the last sample
+ * params:  name - label of the counter
+ *          now - value in this sample
+ *          before - value in the last sample
+ *          seconds - time between the samples
+ */
+void print_rate(char* name, uint64_t now, uint64_t before, double seconds) {
+    printf(" %s %llu (%.0f/s)", name, (unsigned long long)now, 
+            (double)(now - before) / seconds);
+}
+
+/*
+ * prints the counters of one sample and the rates since the last
+ * params:  now - counters in this sample
+ *          before - counters in the last sample
+ *          seconds - time between the samples
+ */
+void print_sample(Metrics* now, Metrics* before, double seconds) {
+    printf("games running %llu finished %llu failed %llu\n", 
+            (unsigned long long)now->gamesRunning,
+            (unsigned long long)now->gamesFinished, 
+            (unsigned long long)now->gamesFailed);
+    print_rate("turns", now->turns, before->turns, seconds);
+    print_rate("sent", now->sent, before->sent, seconds);
+    print_rate("received", now->received, before->received, seconds);
+    printf("\n");
+    print_rate("bytes sent", now->bytesSent, before->bytesSent, seconds);
+    print_rate("bytes received", now->bytesReceived, before->bytesReceived, 
+            seconds);
+    printf("\n reprompts %llu protocol errors %llu timeouts %llu\n",
+            (unsigned long long)now->reprompts, 
+            (unsigned long long)now->protocolErrors,
+            (unsigned long long)now->timeouts);
+
+    printf("%-5s%12s%10s%12s%12s\n", "seat", "moves", "moves/s", 
+            "mean us", "max us");
+    for(uint64_t i = 0; i < now->seats && i < MAX_PLAYERS; i++) {
+        SeatMetrics* seat = &now->seat[i];
+        SeatMetrics* last = &before->seat[i];
+        uint64_t moves = seat->moves - last->moves;
+        char name[ID_SIZE];
+        printf("%-5s%12llu%10.0f%12.1f%12.1f\n", player_name((int)i, name),
+                (unsigned long long)seat->moves, (double)moves / seconds,
+                moves ? (double)(seat->latency - last->latency) / 
+                moves / 1000 : 0.0, (double)seat->maxLatency / 1000);
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+/*
+ * prints usage of hubstat to stderr
+ * returns: E_ARGC
+ */
+Error usage(void) {
+    fprintf(stderr, "Usage: hubstat [-i seconds] [-n samples] stats\n");
+    return E_ARGC;
+}
+
+/*
+ * samples the stats file of a running hub and prints its counters with
+ * rates every interval, until the samples run out or the hub exits
+ */
+int main(int argc, char** argv) {
+    double interval = DEFAULT_INTERVAL;
+    long samples = 0;
+    int option;
+    char* end;
+    opterr = 0;
+    while((option = getopt(argc, argv, "i:n:")) != -1) {
+        switch(option) {
+            case 'i':
+                interval = strtod(optarg, &end);
+                if(*end || interval <= 0) {
+                    return usage();
+                }
+                break;
+            case 'n':
+                samples = strtol(optarg, &end, 10);
+                if(*end || samples < 1) {
+                    return usage();
+                }
+                break;
+            default:
+                return usage();
+        }
+    }
+    if(argc - optind != 1) {
+        return usage();
+    }
+
+    int fd = open(argv[optind], O_RDONLY);
+    Metrics* mapped = fd < 0 ? MAP_FAILED : (Metrics*)mmap(NULL, 
+            sizeof(Metrics), PROT_READ, MAP_SHARED, fd, 0);
+    if(fd >= 0) {
+        close(fd);
+    }
+    if(mapped == MAP_FAILED || 
+            __atomic_load_n(&mapped->magic, __ATOMIC_ACQUIRE) != 
+            METRICS_MAGIC || mapped->version != METRICS_VERSION) {
+        fprintf(stderr, "Cannot read stats from %s\n", argv[optind]);
+        return E_DECKIO;
+    }
+
+    static Metrics before, now;
+    sample(mapped, &before);
+    uint64_t last = metrics_now();
+    struct timespec pause = {(time_t)interval, 
+            (long)((interval - (time_t)interval) * 1e9)};
+    for(long i = 0; !samples || i < samples; i++) {
+        nanosleep(&pause, NULL);
+        int alive = !kill((pid_t)mapped->pid, 0) || errno != ESRCH;
+        sample(mapped, &now);
+        uint64_t taken = metrics_now();
+        print_sample(&now, &before, (double)(taken - last) / 1e9);
+        if(!alive) {
+            break;
+        }
+        before = now;
+        last = taken;
+    }
+    munmap(mapped, sizeof(Metrics));
+
+    return OK;
+}
@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "err.h"
+#include "metrics.h"
+
+static Metrics unmapped; // counted into when there is no stats file
+Metrics* metrics = &unmapped;
+
+/*
+ * reads the monotonic clock
+ * returns: nanoseconds since an arbitrary point
+ */
+uint64_t metrics_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+/*
+ * maps a stats file for the counters, any earlier contents are dropped,
+ * the magic is stored last so readers only see a file once it is set up
+ * params:  path - stats file to create
+ * returns: ERR if the file cannot be created or mapped,
+ *          OK otherwise
+ */
+Error metrics_open(char* path) {
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0) {
+        return ERR;
+    }
+    if(ftruncate(fd, sizeof(Metrics))) {
+        close(fd);
+        return ERR;
+    }
+
+    Metrics* mapped = (Metrics*)mmap(NULL, sizeof(Metrics), 
+            PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(mapped == MAP_FAILED) {
+        return ERR;
+    }
+
+    memcpy(mapped, metrics, sizeof(Metrics));
+    mapped->version = METRICS_VERSION;
+    mapped->pid = getpid();
+    mapped->started = metrics_now();
+    __atomic_store_n(&mapped->magic, METRICS_MAGIC, __ATOMIC_RELEASE);
+    metrics = mapped;
+
+    return OK;
+}
+
+/*
+ * counts a move made from a seat
+ * params:  seat - position of the player in turn order
+ *          latency - nanoseconds the player took
+ */
+void metrics_move(int seat, uint64_t latency) {
+    SeatMetrics* counts = &metrics->seat[seat];
+    __atomic_store_n(&counts->moves, counts->moves + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&counts->latency, counts->latency + latency, 
+            __ATOMIC_RELAXED);
+    if(latency > counts->maxLatency) {
+        __atomic_store_n(&counts->maxLatency, latency, __ATOMIC_RELAXED);
+    }
+    if((uint64_t)seat >= metrics->seats) {
+        __atomic_store_n(&metrics->seats, seat + 1, __ATOMIC_RELAXED);
+    }
+}
+
+/*
+ * unmaps the stats file, the last values stay in it
+ */
+void metrics_close(void) {
+    if(metrics != &unmapped) {
+        munmap(metrics, sizeof(Metrics));
+        metrics = &unmapped;
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include "err.h"
+#include "common.h"
+
+// start of a stats file once the hub has set it up, "AUSM"
+#define METRICS_MAGIC 0x4d535541
+#define METRICS_VERSION 2
+
+// moves made from a seat and the time players took over them,
+// from the hub asking for the move to the reply arriving, in nanoseconds
+typedef struct {
+    uint64_t moves;
+    uint64_t latency;
+    uint64_t maxLatency;
+} SeatMetrics;
+
+// counters and gauges of a running hub, mapped into the stats file;
+// only the hub thread writes and every field is stored whole, 
+// so readers never see a torn value, though fields may be a move apart
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int64_t pid;
+    uint64_t started;
+    uint64_t seats;
+    uint64_t turns;
+    uint64_t sent;
+    uint64_t received;
+    uint64_t bytesSent;
+    uint64_t bytesReceived;
+    uint64_t reprompts;
+    uint64_t protocolErrors;
+    uint64_t timeouts;
+    uint64_t gamesRunning;
+    uint64_t gamesFinished;
+    uint64_t gamesFailed;
+    SeatMetrics seat[MAX_PLAYERS];
+} Metrics;
+
+// counters in use, private memory until a stats file is opened
+extern Metrics* metrics;
+
+// single writer, so an add is a plain load and a store that cannot tear
+#define METRIC_ADD(field, amount) __atomic_store_n(&metrics->field, \
+        metrics->field + (amount), __ATOMIC_RELAXED)
+
+uint64_t metrics_now(void);
+
+Error metrics_open(char* path);
+
+void metrics_move(int seat, uint64_t latency);
+
+void metrics_close(void);
+
+#endif
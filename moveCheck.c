@@ -0,0 +1,234 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "err.h"
+#include "common.h"
+#include "card.h"
+#include "comms.h"
+#include "hub.h"
+#include "moves.h"
+
+// values each field of a position takes from 0, every combination of
+// them is checked on every board size from empty to BOARD_SIZE
+#define GRID_BANK 2
+#define GRID_TOKENS 3
+#define GRID_WILD 3
+#define GRID_DISCOUNT 2
+// positions of the grid for one board size
+#define GRID_POSITIONS (GRID_BANK * GRID_BANK * GRID_BANK * GRID_BANK * \
+        GRID_TOKENS * GRID_TOKENS * GRID_TOKENS * GRID_TOKENS * GRID_WILD * \
+        GRID_DISCOUNT * GRID_DISCOUNT * GRID_DISCOUNT * GRID_DISCOUNT)
+// times the generator is run on every position when it is timed
+#define TIMING_ROUNDS 16
+// mismatches printed before the rest are only counted
+#define MAX_REPORTS 10
+
+// cards of the board, a board of n cards holds the first n,
+// costs run from nothing to more than the grid gives a player
+int boardCards[BOARD_SIZE][CARD_SIZE] = {
+    {'P', 1, 1, 0, 2, 0}, {'B', 1, 0, 1, 1, 1}, {'Y', 2, 2, 2, 0, 0},
+    {'R', 1, 0, 0, 1, 2}, {'P', 3, 3, 1, 1, 0}, {'B', 0, 0, 0, 0, 0},
+    {'Y', 1, 1, 0, 0, 1}, {'R', 2, 0, 2, 3, 0}};
+
+// mismatches found so far
+long mismatches = 0;
+
+/*
+ * sets up the position with the given index of the grid for player 0,
+ * the index is read a field at a time like the digits of a number
+ * params:  game - game to set the bank and board of
+ *          state - state to set player 0 of
+ *          numCards - number of cards on the board
+ *          index - index of the position, below GRID_POSITIONS
+ */
+void set_position(Game* game, PlayerState* state, int numCards,
+        long index) {
+    for(int i = 0; i < TOKEN_SIZE; i++) {
+        game->tokens[i] = index % GRID_BANK;
+        index /= GRID_BANK;
+        state->ownedTokens[0][i] = index % GRID_TOKENS;
+        index /= GRID_TOKENS;
+        state->discount[0][i] = index % GRID_DISCOUNT;
+        index /= GRID_DISCOUNT;
+    }
+    state->wild[0] = index % GRID_WILD;
+    game->stack.numCards = numCards;
+}
+
+/*
+ * asks the hub whether player 0 may make a move, the move is passed
+ * as decode_player_msg would leave it
+ * params:  game - position to check the move in
+ *          state - state of the players
+ *          move - move to check
+ * returns: 1 if valid_move accepts the move,
+ *          0 otherwise
+ */
+int accepted(Game* game, PlayerState* state, Move* move) {
+    int info[CARD_SIZE] = {0};
+    memcpy(info + PURPLE, move->tokens, sizeof(int) * TOKEN_SIZE);
+    Msg msg = {move->type, 0, 0, info, move->wild, move->card, 0, 0};
+    return valid_move(game, state, 0, &msg) == OK;
+}
+
+/*
+ * reports a move the hub and the generator do not agree on
+ * params:  game - position the move was checked in
+ *          state - state of the players
+ *          move - move they disagree on
+ *          why - what went wrong
+ */
+void report(Game* game, PlayerState* state, Move* move, char* why) {
+    if(mismatches++ >= MAX_REPORTS) {
+        return;
+    }
+    fprintf(stderr, "%s: type %d card %d tokens %d,%d,%d,%d wild %d; "
+            "bank %d,%d,%d,%d tokens %d,%d,%d,%d discount %d,%d,%d,%d "
+            "wild %d board %d\n", why, move->type, move->card,
+            move->tokens[0], move->tokens[1], move->tokens[2],
+            move->tokens[3], move->wild, game->tokens[0], game->tokens[1],
+            game->tokens[2], game->tokens[3], state->ownedTokens[0][0],
+            state->ownedTokens[0][1], state->ownedTokens[0][2],
+            state->ownedTokens[0][3], state->discount[0][0],
+            state->discount[0][1], state->discount[0][2],
+            state->discount[0][3], state->wild[0], game->stack.numCards);
+}
+
+/*
+ * checks a move against the hub, the generator and what the rules say
+ * params:  game - position to check the move in
+ *          state - state of the players
+ *          moves - moves listed by legal_moves for the position
+ *          count - number of moves listed
+ *          move - move to check
+ *          legal - whether the rules allow the move
+ * returns: 1 if the hub accepted the move,
+ *          0 otherwise
+ */
+int check_move(Game* game, PlayerState* state, Move* moves, int count,
+        Move* move, int legal) {
+    int valid = accepted(game, state, move);
+    int listed = find_move(moves, count, move) > -1;
+    if(valid != listed) {
+        report(game, state, move, valid ? "accepted but not listed" :
+                "listed but rejected");
+    } else if(valid != legal) {
+        report(game, state, move, legal ? "legal but rejected" :
+                "illegal but accepted");
+    }
+
+    return valid;
+}
+
+/*
+ * checks every take in {0,1}^4 and purchases of every slot on and off
+ * the board, then that the moves the hub accepted are all the generator
+ * listed
+ * params:  game - position to check
+ *          state - state of the players
+ * returns: number of moves checked
+ */
+int check_position(Game* game, PlayerState* state) {
+    Move moves[MAX_MOVES];
+    int count = legal_moves(game->tokens, &game->stack, state->discount[0],
+            state->ownedTokens[0], state->wild[0], moves);
+    int found = 0;
+    int checked = 0;
+    for(int take = 0; take < 1 << TOKEN_SIZE; take++) {
+        Move move = {TAKE, -1, {0}, 0};
+        int colours = 0;
+        int inBank = 1;
+        for(int i = 0; i < TOKEN_SIZE; i++) {
+            move.tokens[i] = take >> i & 1;
+            colours += move.tokens[i];
+            inBank = inBank && (!move.tokens[i] || game->tokens[i] > 0);
+        }
+        found += check_move(game, state, moves, count, &move,
+                colours == 3 && inBank);
+        checked++;
+    }
+
+    for(int slot = -1; slot <= BOARD_SIZE; slot++) {
+        Move move = {PURCHASE, slot, {0}, 0};
+        int onBoard = slot > -1 && slot < game->stack.numCards;
+        for(int i = 0; onBoard && i < TOKEN_SIZE; i++) { // tokens first
+            int cost = boardCards[slot][PURPLE + i] - state->discount[0][i];
+            cost = cost < 0 ? 0 : cost;
+            int owned = state->ownedTokens[0][i];
+            move.tokens[i] = cost < owned ? cost : owned;
+            move.wild += cost - move.tokens[i];
+        }
+        found += check_move(game, state, moves, count, &move,
+                onBoard && move.wild <= state->wild[0]);
+
+        Move overpaid = move; // a wild more than the card costs
+        overpaid.wild++;
+        found += check_move(game, state, moves, count, &overpaid, 0);
+        Move extra = move; // a token more than the card costs
+        extra.tokens[slot > 0 ? slot % TOKEN_SIZE : 0]++;
+        found += check_move(game, state, moves, count, &extra, 0);
+        checked += 3;
+    }
+
+    if(found != count - 1) { // every move but the wild should be found
+        Move none = {WILD, -1, {0}, 0};
+        report(game, state, &none, "generated moves not all accepted");
+    }
+    return checked;
+}
+
+/*
+ * times legal_moves over every position of the grid
+ * params:  game - game to set the positions in
+ *          state - state of the players
+ */
+void time_generator(Game* game, PlayerState* state) {
+    Move moves[MAX_MOVES];
+    long long calls = 0;
+    long long listed = 0;
+    long long start = time_usec();
+    for(int round = 0; round < TIMING_ROUNDS; round++) {
+        for(int numCards = 0; numCards <= BOARD_SIZE; numCards++) {
+            for(long i = 0; i < GRID_POSITIONS; i++) {
+                set_position(game, state, numCards, i);
+                listed += legal_moves(game->tokens, &game->stack,
+                        state->discount[0], state->ownedTokens[0],
+                        state->wild[0], moves);
+                calls++;
+            }
+        }
+    }
+    long long elapsed = time_usec() - start;
+
+    printf("legal_moves: %lld calls in %lldms, %.1fns per call, "
+            "%.2f moves per call\n", calls, elapsed / 1000,
+            elapsed * 1000.0 / calls, (double)listed / calls);
+}
+
+int main(void) {
+    Game game;
+    memset(&game, 0, sizeof(Game));
+    Card deck[BOARD_SIZE];
+    for(int i = 0; i < BOARD_SIZE; i++) {
+        deck[i] = boardCards[i];
+    }
+    game.stack.deck = deck;
+    game.pCount = 1;
+    PlayerState state;
+    init_player_state(&state, 1);
+
+    long positions = 0;
+    long checked = 0;
+    for(int numCards = 0; numCards <= BOARD_SIZE; numCards++) {
+        for(long i = 0; i < GRID_POSITIONS; i++, positions++) {
+            set_position(&game, &state, numCards, i);
+            checked += check_position(&game, &state);
+        }
+    }
+    printf("checked %ld moves in %ld positions, %ld mismatches\n",
+            checked, positions, mismatches);
+    time_generator(&game, &state);
+
+    shred_player_state(&state);
+    return mismatches ? ERR : OK;
+}
@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "err.h"
+#include "common.h"
+#include "comms.h"
+#include "card.h"
+#include "playerCommon.h"
+#include "moves.h"
+
+/*
+ * converts a card color to the index of the discount it gives
+ * params:  color - color of the card
+ * returns: index into discount array
+ */
+int discount_index(int color) {
+    switch(color) {
+        case 'B':
+            return 1;
+        case 'Y':
+            return 2;
+        case 'R':
+            return 3;
+        default:
+            return 0;
+    }
+}
+
+/*
+ * works out what a player pays for a card, tokens of each colour first 
+ * and wild tokens for the rest
+ * params:  card - card to buy
+ *          discount - discount from owned cards
+ *          tokens - owned tokens
+ *          wild - number of owned wild tokens
+ *          paid - where to save the tokens paid of each colour, 
+ *                 may be NULL
+ * returns: -1 if the card cannot be afforded,
+ *          number of wild tokens paid otherwise
+ */
+int card_payment(Card card, int* discount, int* tokens, int wild, 
+        int* paid) {
+    int usedWild = 0;
+    for(int i = 0; i < TOKEN_SIZE; i++) {
+        int cost = card[i + 2] - discount[i];
+        if(cost > tokens[i] + wild - usedWild) {
+            return -1;
+        }
+
+        if(cost > tokens[i]) {
+            usedWild += cost - tokens[i];
+        }
+        if(paid) {
+            paid[i] = cost < 1 ? 0 : (cost < tokens[i] ? cost : tokens[i]);
+        }
+    }
+
+    return usedWild;
+}
+
+/*
+ * lists every legal move of a player without allocating,
+ * only the first BOARD_SIZE cards of the board can be bought
+ * params:  bank - tokens left to take
+ *          board - cards face up
+ *          discount - discount of the player from owned cards
+ *          tokens - tokens owned by the player
+ *          wild - wild tokens owned by the player
+ *          moves - array of at least MAX_MOVES to save moves into
+ * returns: number of moves saved, purchases first and wild last
+ */
+int legal_moves(int* bank, Stack* board, int* discount, int* tokens, 
+        int wild, Move* moves) {
+    int count = 0;
+    for(int i = 0; i < board->numCards && i < BOARD_SIZE; i++) {
+        int paid = card_payment(board->deck[i], discount, tokens, wild, 
+                moves[count].tokens);
+        if(paid < 0) {
+            continue;
+        }
+
+        moves[count].type = PURCHASE;
+        moves[count].card = i;
+        moves[count++].wild = paid;
+    }
+
+    for(int skip = TOKEN_SIZE - 1; skip > -1; skip--) {
+        int available = 1;
+        for(int j = 0; j < TOKEN_SIZE; j++) {
+            if(j != skip && bank[j] < 1) {
+                available = 0;
+            }
+        }
+
+        if(available) {
+            moves[count].type = TAKE;
+            moves[count].card = -1;
+            moves[count].wild = 0;
+            for(int j = 0; j < TOKEN_SIZE; j++) {
+                moves[count].tokens[j] = j != skip;
+            }
+            count++;
+        }
+    }
+
+    memset(&moves[count], 0, sizeof(Move));
+    moves[count].type = WILD;
+    moves[count].card = -1;
+    return count + 1;
+}
+
+/*
+ * finds a move among those listed by legal_moves, a purchase only 
+ * matches if it is paid exactly as listed
+ * params:  moves - moves listed by legal_moves
+ *          count - number of moves listed
+ *          move - move to look for, card is -1 unless it is a purchase
+ * returns: -1 if the move is not listed,
+ *          position of the move otherwise
+ */
+int find_move(Move* moves, int count, Move* move) {
+    for(int i = 0; i < count; i++) {
+        if(moves[i].type == move->type && moves[i].card == move->card &&
+                moves[i].wild == move->wild && !memcmp(moves[i].tokens, 
+                move->tokens, sizeof(int) * TOKEN_SIZE)) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/*
+ * plays a legal move in place, a card bought leaves the board and is
+ * not replaced since the deck is unknown to players
+ * params:  game - position to play on
+ *          player - stats of the player moving
+ *          move - legal move to play
+ *          undo - where to save what undo_move needs to take it back
+ */
+void apply_move(Game* game, Opponent* player, Move* move, Undo* undo) {
+    undo->move = *move;
+    undo->player = player;
+    undo->card = NULL;
+    if(move->type == WILD) {
+        player->wild++;
+        return;
+    }
+
+    if(move->type == TAKE) {
+        for(int i = 0; i < TOKEN_SIZE; i++) {
+            game->tokens[i] -= move->tokens[i];
+            player->tokens[i] += move->tokens[i];
+        }
+        return;
+    }
+
+    Card card = game->stack.deck[move->card];
+    for(int i = 0; i < TOKEN_SIZE; i++) {
+        game->tokens[i] += move->tokens[i];
+        player->tokens[i] -= move->tokens[i];
+    }
+    player->wild -= move->wild;
+    player->discount[discount_index(card[COLOR])]++;
+    player->numPoints += card[POINTS];
+
+    undo->card = card;
+    memmove(&game->stack.deck[move->card], &game->stack.deck[move->card + 1],
+            sizeof(Card) * (game->stack.numCards - move->card - 1));
+    game->stack.numCards--;
+}
+
+/*
+ * takes back the last move applied, undos must be taken back in the 
+ * reverse order they were made
+ * params:  game - position the move was played on
+ *          undo - record saved when the move was applied
+ */
+void undo_move(Game* game, Undo* undo) {
+    Move* move = &undo->move;
+    Opponent* player = undo->player;
+    if(move->type == WILD) {
+        player->wild--;
+        return;
+    }
+
+    if(move->type == TAKE) {
+        for(int i = 0; i < TOKEN_SIZE; i++) {
+            game->tokens[i] += move->tokens[i];
+            player->tokens[i] -= move->tokens[i];
+        }
+        return;
+    }
+
+    memmove(&game->stack.deck[move->card + 1], &game->stack.deck[move->card],
+            sizeof(Card) * (game->stack.numCards - move->card));
+    game->stack.deck[move->card] = undo->card;
+    game->stack.numCards++;
+
+    for(int i = 0; i < TOKEN_SIZE; i++) {
+        game->tokens[i] -= move->tokens[i];
+        player->tokens[i] += move->tokens[i];
+    }
+    player->wild += move->wild;
+    player->discount[discount_index(undo->card[COLOR])]--;
+    player->numPoints -= undo->card[POINTS];
+}
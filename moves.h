@@ -0,0 +1,48 @@
+#ifndef MOVES_H
+#define MOVES_H
+
+#include "err.h"
+#include "common.h"
+#include "comms.h"
+#include "card.h"
+#include "playerCommon.h"
+
+// number of cards face up at once
+#define BOARD_SIZE 8
+// most legal moves there can be: every way to take 3 colours of token,
+// a wild and buying any card on the board
+#define MAX_MOVES (TOKEN_SIZE + 1 + BOARD_SIZE)
+
+// a single legal move, tokens holds the tokens taken or paid,
+// wild the wild tokens paid and card the position of the card bought
+typedef struct {
+    Comm type;
+    int card;
+    int tokens[TOKEN_SIZE];
+    int wild;
+} Move;
+
+// what apply_move changed, enough for undo_move to put it back:
+// the move with its token and wild deltas, the player who made it and 
+// the card bought, which was at move.card on the board
+typedef struct {
+    Move move;
+    Opponent* player;
+    Card card;
+} Undo;
+
+int discount_index(int color);
+
+int card_payment(Card card, int* discount, int* tokens, int wild, 
+        int* paid);
+
+int legal_moves(int* bank, Stack* board, int* discount, int* tokens, 
+        int wild, Move* moves);
+
+int find_move(Move* moves, int count, Move* move);
+
+void apply_move(Game* game, Opponent* player, Move* move, Undo* undo);
+
+void undo_move(Game* game, Undo* undo);
+
+#endif
@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+#include "err.h"
+#include "options.h"
+
+/*
+ * sets the default hub options
+ * params:  options - struct to fill with defaults
+ */
+void default_options(Options* options) {
+    options->logSink = SINK_TEXT;
+    options->resultFile = NULL;
+    options->jobFile = NULL;
+    options->tables = SERVER_TABLES;
+    options->statsFile = NULL;
+    options->placement = PLACE_NONE;
+    options->cpuLimit = 0;
+    options->memoryLimit = 0;
+    options->zygote = 0;
+    options->maxRounds = 0;
+    options->moveBudget = 0;
+    options->gameBudget = 0;
+    options->interned = 0;
+    options->usage = 0;
+}
+
+/*
+ * reads the name of an event log sink
+ * params:  input - name of the sink
+ *          sink - where to save the sink
+ * returns: ERR if the name is not a sink,
+ *          OK otherwise
+ */
+Error parse_sink(char* input, LogSink* sink) {
+    if(!strcmp(input, "text")) {
+        *sink = SINK_TEXT;
+    } else if(!strcmp(input, "quiet")) {
+        *sink = SINK_QUIET;
+    } else if(!strcmp(input, "binary")) {
+        *sink = SINK_BINARY;
+    } else {
+        return ERR;
+    }
+    return OK;
+}
+
+/*
+ * reads a positive number given to an option
+ * params:  input - option value
+ *          number - where to save the number
+ * returns: ERR if the value is not a positive int,
+ *          OK otherwise
+ */
+Error parse_positive(char* input, int* number) {
+    char* end;
+    long int value = strtol(input, &end, 10);
+    if(*end || end == input || value < 1 || value > INT_MAX) {
+        return ERR;
+    }
+    *number = (int)value;
+    return OK;
+}
+
+/*
+ * reads the hub options, parsing stops at the first positional argument
+ * params:  argc - number of invocation arguments
+ *          argv - array of invocation arguments
+ *          options - struct to save the options into
+ *          first - where to save the index of the first positional argument
+ * returns: E_ARGC if an option is unknown or missing its value,
+ *          E_ARGV if an option value is invalid,
+ *          OK otherwise
+ */
+Error parse_options(int argc, char** argv, Options* options, int* first) {
+    default_options(options);
+    opterr = 0;
+    int option;
+    while((option = getopt(argc, argv, "+l:r:s:c:m:a:C:M:zR:t:g:iu")) != -1) {
+        switch(option) {
+            case 'l':
+                if(parse_sink(optarg, &options->logSink) != OK) {
+                    return E_ARGV;
+                }
+                break;
+            case 'r':
+                options->resultFile = optarg;
+                break;
+            case 's':
+                options->jobFile = optarg;
+                break;
+            case 'm':
+                options->statsFile = optarg;
+                break;
+            case 'a':
+                if(parse_placement(optarg, &options->placement) != OK) {
+                    return E_ARGV;
+                }
+                break;
+            case 'c':
+                if(parse_positive(optarg, &options->tables) != OK) {
+                    return E_ARGV;
+                }
+                break;
+            case 'C':
+                if(parse_positive(optarg, &options->cpuLimit) != OK) {
+                    return E_ARGV;
+                }
+                break;
+            case 'M':
+                if(parse_positive(optarg, &options->memoryLimit) != OK) {
+                    return E_ARGV;
+                }
+                break;
+            case 'z':
+                options->zygote = 1;
+                break;
+            case 'R':
+                if(parse_positive(optarg, &options->maxRounds) != OK) {
+                    return E_ARGV;
+                }
+                break;
+            case 't':
+                if(parse_positive(optarg, &options->moveBudget) != OK) {
+                    return E_ARGV;
+                }
+                break;
+            case 'g':
+                if(parse_positive(optarg, &options->gameBudget) != OK) {
+                    return E_ARGV;
+                }
+                break;
+            case 'i':
+                options->interned = 1;
+                break;
+            case 'u':
+                options->usage = 1;
+                break;
+            default:
+                return E_ARGC;
+        }
+    }
+    *first = optind;
+
+    return OK;
+}
@@ -0,0 +1,42 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include "err.h"
+#include "eventLog.h"
+#include "placement.h"
+
+// games the hub runs at once when serving a jobs file
+#define SERVER_TABLES 64
+
+// hub settings given as options before the positional arguments,
+// a jobFile makes the hub serve every game in it instead of one,
+// a statsFile gets the live counters of the hub (see metrics.h),
+// placement decides which cpus the hub and players run on,
+// player processes are capped at cpuLimit seconds and memoryLimit 
+// megabytes of address space, 0 for no cap,
+// zygote has players forked by the zygote rather than exec'd (see zygote.h),
+// a game still going after maxRounds rounds is aborted, 0 for no limit,
+// players are given moveBudget milliseconds per move and gameBudget 
+// milliseconds over the game to reply in, 0 for no budget,
+// interned has the card table sent once and cards named by id after that,
+// usage has what each player process cost printed once the game is over
+typedef struct {
+    LogSink logSink;
+    char* resultFile;
+    char* jobFile;
+    int tables;
+    char* statsFile;
+    Placement placement;
+    int cpuLimit;
+    int memoryLimit;
+    int zygote;
+    int maxRounds;
+    int moveBudget;
+    int gameBudget;
+    int interned;
+    int usage;
+} Options;
+
+Error parse_options(int argc, char** argv, Options* options, int* first);
+
+#endif
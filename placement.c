@@ -0,0 +1,139 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include "err.h"
+#include "placement.h"
+
+// names of the placements, in the order of Placement
+static char* placementNames[] = {"none", "hub", "pack", "spread", "share"};
+
+// cpus the hub was allowed to run on when it was placed
+static int cpuCount = 0;
+static int cpus[CPU_SETSIZE];
+
+/*
+ * reads the name of a placement
+ * params:  input - name of the placement
+ *          placement - where to save the placement
+ * returns: ERR if the name is not a placement,
+ *          OK otherwise
+ */
+Error parse_placement(char* input, Placement* placement) {
+    for(int i = PLACE_NONE; i <= PLACE_SHARE; i++) {
+        if(!strcmp(input, placementNames[i])) {
+            *placement = (Placement)i;
+            return OK;
+        }
+    }
+
+    return ERR;
+}
+
+/*
+ * pins a process to a single cpu
+ * params:  pid - process to pin, 0 for the calling process
+ *          cpu - cpu to run on
+ */
+void pin_cpu(pid_t pid, int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    sched_setaffinity(pid, sizeof(set), &set);
+}
+
+/*
+ * notes the cpus the hub may use and pins the hub to the first of them,
+ * players forked afterwards are placed relative to it
+ * params:  placement - placement in use
+ */
+void place_hub(Placement placement) {
+    cpu_set_t set;
+    if(placement == PLACE_NONE || 
+            sched_getaffinity(0, sizeof(set), &set)) {
+        return;
+    }
+
+    cpuCount = 0;
+    for(int i = 0; i < CPU_SETSIZE; i++) {
+        if(CPU_ISSET(i, &set)) {
+            cpus[cpuCount++] = i;
+        }
+    }
+    pin_cpu(0, cpus[0]);
+}
+
+/*
+ * works out the cpu of a player
+ * params:  placement - placement in use
+ *          pID - seat of the player
+ *          pCount - number of players in the game
+ * returns: cpu to pin the player to,
+ *          -1 if the player is left to the scheduler
+ */
+int player_cpu(Placement placement, int pID, int pCount) {
+    if(!cpuCount) {
+        return -1;
+    }
+
+    switch(placement) {
+        case PLACE_PACK:
+            return cpus[(1 + pID) % cpuCount];
+        case PLACE_SPREAD:
+            if(cpuCount == 1) {
+                return cpus[0];
+            }
+            return cpus[1 + (int)((long)pID * (cpuCount - 1) / pCount)];
+        case PLACE_SHARE:
+            return cpus[0];
+        default:
+            return -1;
+    }
+}
+
+/*
+ * pins a player once it is started
+ * params:  placement - placement in use
+ *          pid - the player, 0 for the calling process
+ *          pID - seat of the player
+ *          pCount - number of players in the game
+ */
+void place_player(Placement placement, pid_t pid, int pID, int pCount) {
+    int cpu = player_cpu(placement, pID, pCount);
+    if(cpu >= 0) {
+        pin_cpu(pid, cpu);
+    }
+}
+
+/*
+ * prints the placement in use and the cpu of the hub and every player
+ * to stderr, once per process
+ * params:  placement - placement in use
+ *          pCount - number of players in the game
+ */
+void report_placement(Placement placement, int pCount) {
+    static int reported = 0;
+    if(placement == PLACE_NONE || reported) {
+        return;
+    }
+    reported = 1;
+
+    if(!cpuCount) {
+        fprintf(stderr, "Placement %s unavailable\n", 
+                placementNames[placement]);
+        return;
+    }
+
+    fprintf(stderr, "Placement %s: hub on cpu %d, players ", 
+            placementNames[placement], cpus[0]);
+    if(placement == PLACE_HUB) {
+        fprintf(stderr, "unpinned\n");
+        return;
+    }
+    fprintf(stderr, "on cpus");
+    for(int i = 0; i < pCount; i++) {
+        fprintf(stderr, " %d", player_cpu(placement, i, pCount));
+    }
+    fprintf(stderr, "\n");
+}
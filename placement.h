@@ -0,0 +1,27 @@
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+#include <sys/types.h>
+#include "err.h"
+
+// where the hub and players are run, cpus are those the hub may use,
+// in the order the kernel numbers them
+typedef enum {
+    PLACE_NONE,     // the scheduler decides
+    PLACE_HUB,      // the hub is pinned to the first cpu
+    PLACE_PACK,     // the hub and then each player on the next cpu
+    PLACE_SPREAD,   // the hub on the first cpu, players evenly over the rest
+    PLACE_SHARE     // the hub and every player on the first cpu
+} Placement;
+
+Error parse_placement(char* input, Placement* placement);
+
+void place_hub(Placement placement);
+
+int player_cpu(Placement placement, int pID, int pCount);
+
+void place_player(Placement placement, pid_t pid, int pID, int pCount);
+
+void report_placement(Placement placement, int pCount);
+
+#endif
@@ -3,12 +3,16 @@
 #include <string.h>
 #include <limits.h>
 #include <signal.h>
+#include <unistd.h>
+#include <poll.h>
 #include "err.h"
 #include "common.h"
 #include "playerCommon.h"
 #include "comms.h"
 #include "signalHandler.h"
 #include "token.h"
+#include "reader.h"
+#include "trace.h"
 
 /*
  * checks if the given string is valid
@@ -19,7 +23,7 @@
 int check_pcount(char* input) {
     char* temp;
     long int pCount = strtol(input, &temp, 10);
-    if(pCount < 2 || pCount > 26 || !is_all_num(input)) {
+    if(pCount < 2 || pCount > MAX_PLAYERS || !is_all_num(input)) {
         return ERR;
     }
     return (int)pCount;
@@ -76,12 +80,24 @@ void init_player_game(int pID, int pCount, Game* game) {
     game->numPoints = 0;
     game->stack.numCards = 0;
     game->stack.deck = (Deck)malloc(sizeof(Card));
+    game->stack.shared = 0;
+    game->table.numCards = 0;
+    game->table.cards = NULL;
     memset(game->discount, 0, sizeof(int) * TOKEN_SIZE);
     memset(game->tokens, 0, sizeof(int) * TOKEN_SIZE);
     memset(game->ownedTokens, 0, sizeof(int) * TOKEN_SIZE);
     game->wild = 0;
 }
 
+/*
+ * frees the cards of a game started by init_player_game
+ * params:  game - struct containing game relevant information
+ */
+void shred_player_game(Game* game) {
+    shred_stack(&game->stack);
+    shred_table(&game->table);
+}
+
 /*
  * initalizes local record of opponents stats
  * params:  pCount - number of players
@@ -108,6 +124,7 @@ Opponent* init_opponents(int pCount) {
  * returns: UTIL to indicate end of game
  */
 Error print_winners(int pCount, Opponent* opponents) {
+    char name[ID_SIZE];
     fprintf(stderr, "Game over. Winners are ");
     int max = 0;
     for(int i = 0; i < pCount; i++) {
@@ -126,7 +143,7 @@ Error print_winners(int pCount, Opponent* opponents) {
 
     for(int i = 0; i < pCount; i++) {
         if(opponents[i].numPoints == max) {
-            fprintf(stderr, "%c", (char)(i + TOCHAR));
+            fprintf(stderr, "%s", player_name(i, name));
             if(--count) {
                 fprintf(stderr, ",");
             }
@@ -139,22 +156,15 @@ Error print_winners(int pCount, Opponent* opponents) {
 }
 
 /*
- * encodes a message and sends it to the given destination
+ * encodes a message and sends it to the hub
  * params:  game - struct containing relevang game information
  *          msg - message to encode
  * returns: E_COMMERR if broken pipe or invalid message,
  *          OK otherwise
  */
 Error send_move(Game* game, Msg* msg) {
-    fprintf(stderr, "Received dowhat\n");
-    msg->player = game->pID + TOCHAR;    
-    
-    char* encodedMsg = encode_player(msg);
+    char* encodedMsg = encode_player(msg, game->arena);
     if(!encodedMsg) {
-        if(msg->type == PURCHASE || msg->type == TAKE) {
-            free(msg->info);
-        }
-
         return E_COMMERR;
     }
 
@@ -164,12 +174,7 @@ Error send_move(Game* game, Msg* msg) {
    
     fprintf(stdout, "%s\n", encodedMsg);
     fflush(stdout);
-    free(encodedMsg);
-    
-    if(msg->type == PURCHASE || msg->type == TAKE) {
-        free(msg->info);
-    }
-    free(msg);
+    fflush(stderr); // status is buffered, catch up once per turn
     
     if(check_signal()) {
         return E_COMMERR;
@@ -178,16 +183,62 @@ Error send_move(Game* game, Msg* msg) {
     return OK;
 }
 
+/*
+ * adds a card sent by the hub to the card table, 
+ * the table is complete once the first card is dealt
+ * params:  game - struct containing relevant game information
+ *          msg - struct containing message contents
+ * returns: E_COMMERR if a card has already been dealt or it is invalid,
+ *          OK otherwise
+ */
+Error table_entry(Game* game, Msg* msg) {
+    if(game->stack.numCards || game->stack.shared || 
+            table_add(&game->table, msg->info) != OK) {
+        return E_COMMERR;
+    }
+
+    return OK;
+}
+
+/*
+ * puts a newly dealt card on the board, a card named by its id is
+ * shared with the card table instead of copied
+ * params:  game - struct containing relevant game information
+ *          msg - struct containing message contents
+ * returns: E_COMMERR if the card is unknown or the board mixes the two,
+ *          OK otherwise
+ */
+Error dealt_card(Game* game, Msg* msg) {
+    Stack* stack = &game->stack;
+    if(msg->info[COLOR]) {
+        return stack->shared ? E_COMMERR : new_card(stack, msg->info);
+    }
+
+    Card card = table_card(&game->table, msg->card);
+    if(!card || (stack->numCards && !stack->shared)) {
+        return E_COMMERR;
+    }
+    stack->shared = 1;
+    return share_card(stack, card) == OK ? OK : E_COMMERR;
+}
+
 /*
  * updates player information and deck when card is bought
  * params:  game - struct containing relevang game information
  *          opponents - array of structs containing player information
  *          msg - struct containing message contents
- * returns: E_COMMERR if removecard fails,
+ * returns: E_COMMERR if removecard fails or the card is unknown,
  *          OK otherwise
  */
 Error bought_card(Game* game, Opponent* opponents, Msg* msg) {
-    opponents[(int)(msg->player - TOCHAR)].numPoints += msg->info[POINTS];
+    if(game->stack.shared) { // named by its id, not its position
+        msg->card = find_card(&game->stack, 
+                table_card(&game->table, msg->card));
+    }
+    if(msg->card < 0 || msg->card >= game->stack.numCards) {
+        return E_COMMERR;
+    }
+    opponents[msg->player].numPoints += msg->info[POINTS];
     int discountColor = 0;
     switch(game->stack.deck[msg->card][COLOR]) { // do nothing if purple
         case 'B':
@@ -200,12 +251,12 @@ Error bought_card(Game* game, Opponent* opponents, Msg* msg) {
             discountColor = 3;
     }
 
-    opponents[(int)(msg->player - TOCHAR)].discount[discountColor] += 1;
-    opponents[(int)(msg->player - TOCHAR)].numPoints += 
+    opponents[msg->player].discount[discountColor] += 1;
+    opponents[msg->player].numPoints += 
             game->stack.deck[msg->card][POINTS];
-    opponents[(int)(msg->player - TOCHAR)].wild -= msg->wild;
+    opponents[msg->player].wild -= msg->wild;
    
-    if(msg->player == game->pID + TOCHAR) {
+    if(msg->player == game->pID) {
         game->discount[discountColor] += 1;
         game->numPoints += game->stack.deck[msg->card][POINTS];
     }
@@ -230,26 +281,48 @@ Error bought_card(Game* game, Opponent* opponents, Msg* msg) {
 }
 
 /*
- * prints the status of every players and the cards in play
- * params:  game - struct containing relevang game information
- *          opponents - array of structs containing player information
- *          int msgType - type of message preceeding this function call
- *          err - error status of game
+ * reads the status mode from PLAYER_STATUS, full if unset or invalid
+ * params:  status - struct to initialize
+ *          pCount - number of players
  */
-void print_status(Game* game, Opponent* opponents, int msgType, Error err) {
-    if(msgType == DOWHAT || msgType == EOG || err != OK || check_signal()) {
+void init_status(Status* status, int pCount) {
+    char* mode = getenv("PLAYER_STATUS");
+    status->mode = STATUS_FULL;
+    status->every = 1;
+    status->moves = 0;
+    status->numCards = 0;
+    status->board = NULL;
+    status->opponents = NULL;
+    if(!mode) {
         return;
     }
 
-#ifdef TEST
-    return;
-#endif
+    if(!strcmp(mode, "off")) {
+        status->mode = STATUS_OFF;
+    } else if(!strcmp(mode, "diff")) {
+        status->mode = STATUS_DIFF;
+        status->opponents = (Opponent*)calloc(pCount, sizeof(Opponent));
+        for(int i = 0; i < pCount; i++) {
+            status->opponents[i].id = i;
+        }
+    } else if(env_number("PLAYER_STATUS", 0) > 0) {
+        status->mode = STATUS_EVERY;
+        status->every = env_number("PLAYER_STATUS", STATUS_EVERY_MOVES);
+    }
+}
 
+/*
+ * prints the board and every player in full
+ * params:  game - struct containing relevang game information
+ *          opponents - array of structs containing player information
+ */
+void print_full_status(Game* game, Opponent* opponents) {
+    char name[ID_SIZE];
     print_deck(game->stack.deck, game->stack.numCards);
     for(int i = 0; i < game->pCount; i++) {
-        fprintf(stderr, "Player %c:%d:Discounts=%d,%d,%d,%d"
+        fprintf(stderr, "Player %s:%d:Discounts=%d,%d,%d,%d"
                 ":Tokens=%d,%d,%d,%d,%d\n", 
-                (char)(opponents[i].id + TOCHAR), opponents[i].numPoints,
+                player_name(opponents[i].id, name), opponents[i].numPoints,
                 opponents[i].discount[0], opponents[i].discount[1], 
                 opponents[i].discount[2], opponents[i].discount[3],
                 opponents[i].tokens[0], opponents[i].tokens[1],
@@ -259,54 +332,304 @@ void print_status(Game* game, Opponent* opponents, int msgType, Error err) {
 }
 
 /*
- * main driver for logic of shenzi, banzai, and ed
+ * prints the cards and player fields that changed since the last print,
+ * cards no longer on the board are printed as gone
+ * params:  status - state last printed, updated to the current state
+ *          game - struct containing relevang game information
+ *          opponents - array of structs containing player information
+ */
+void print_status_diff(Status* status, Game* game, Opponent* opponents) {
+    Stack* stack = &game->stack;
+    if(stack->numCards > status->numCards) {
+        status->board = (int*)realloc(status->board, 
+                sizeof(int) * CARD_SIZE * stack->numCards);
+    }
+    for(int i = 0; i < stack->numCards; i++) {
+        int* last = status->board + i * CARD_SIZE;
+        if(i >= status->numCards || 
+                memcmp(last, stack->deck[i], sizeof(int) * CARD_SIZE)) {
+            print_card(stack->deck[i], i);
+            memcpy(last, stack->deck[i], sizeof(int) * CARD_SIZE);
+        }
+    }
+    for(int i = stack->numCards; i < status->numCards; i++) {
+        fprintf(stderr, "Card %d:gone\n", i);
+    }
+    status->numCards = stack->numCards;
+
+    for(int i = 0; i < game->pCount; i++) {
+        Opponent* now = &opponents[i];
+        Opponent* last = &status->opponents[i];
+        int points = now->numPoints != last->numPoints;
+        int discount = memcmp(now->discount, last->discount, 
+                sizeof(now->discount));
+        int tokens = memcmp(now->tokens, last->tokens, 
+                sizeof(now->tokens)) || now->wild != last->wild;
+        if(!points && !discount && !tokens) {
+            continue;
+        }
+
+        char name[ID_SIZE];
+        fprintf(stderr, "Player %s", player_name(now->id, name));
+        if(points) {
+            fprintf(stderr, ":Points=%d", now->numPoints);
+        }
+        if(discount) {
+            fprintf(stderr, ":Discounts=%d,%d,%d,%d", now->discount[0],
+                    now->discount[1], now->discount[2], now->discount[3]);
+        }
+        if(tokens) {
+            fprintf(stderr, ":Tokens=%d,%d,%d,%d,%d", now->tokens[0], 
+                    now->tokens[1], now->tokens[2], now->tokens[3], 
+                    now->wild);
+        }
+        fprintf(stderr, "\n");
+        *last = *now;
+    }
+}
+
+/*
+ * prints the status of the players and the cards in play,
+ * as much as the status mode asks for
+ * params:  status - status mode and the state last printed
+ *          game - struct containing relevang game information
+ *          opponents - array of structs containing player information
+ *          int msgType - type of message preceeding this function call
+ *          err - error status of game
+ */
+void print_status(Status* status, Game* game, Opponent* opponents, 
+        int msgType, Error err) {
+    if(msgType == DOWHAT || msgType == EOG || msgType == CARD || 
+            err != OK || check_signal()) {
+        return;
+    }
+
+#ifdef TEST
+    return;
+#endif
+
+    switch(status->mode) {
+        case STATUS_FULL:
+            print_full_status(game, opponents);
+            break;
+        case STATUS_EVERY:
+            if(msgType != PURCHASED && msgType != TOOK && msgType != WILD) {
+                break;
+            }
+            if(++status->moves % status->every == 0) {
+                print_full_status(game, opponents);
+            }
+            break;
+        case STATUS_DIFF:
+            print_status_diff(status, game, opponents);
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+ * frees memory used to remember the last status
+ * params:  status - status to free
+ */
+void shred_status(Status* status) {
+    free(status->board);
+    free(status->opponents);
+}
+
+/*
+ * starts a players view of the game,
+ * memory for moves comes from an arena reset every turn
+ * params:  runtime - runtime to initialize
+ *          game - struct containing game relevant information
+ *          playerMove - function pointer to the player-specific move logic
+ *          quiet - 1: print nothing to stderr, 0: print status
+ */
+void runtime_init(Runtime* runtime, Game* game, 
+        Msg* (*playerMove)(Game*, ...), int quiet) {
+    runtime->game = game;
+    runtime->opponents = init_opponents(game->pCount);
+    runtime->playerMove = playerMove;
+    runtime->quiet = quiet;
+    runtime->version = 0;
+    runtime->speculated = NULL;
+    runtime->speculatedVersion = 0;
+    arena_init(&runtime->arena, TURN_BLOCK);
+    game->arena = &runtime->arena;
+    init_status(&runtime->status, game->pCount);
+    if(quiet) {
+        runtime->status.mode = STATUS_OFF;
+    }
+}
+
+/*
+ * updates the players view of the game with a message from the hub,
+ * asking the player for a move on dowhat, within the budget it carries,
+ * unless the move was already worked out for the view as it stands
+ * params:  runtime - players view of the game
+ *          msg - decoded message from the hub
+ *          reply - where to save the move, valid until the next dowhat
+ * returns: E_COMMERR if bad message received,
+ *          UTIL for end of game,
+ *          OK otherwise
+ */
+Error runtime_handle(Runtime* runtime, Msg* msg, Msg** reply) {
+    Game* game = runtime->game;
+    Error err = OK;
+    *reply = NULL;
+    if((msg->type == PURCHASED || msg->type == TOOK || msg->type == WILD) &&
+            msg->player >= game->pCount) { // ids go past the player count
+        return E_COMMERR;
+    }
+
+    switch(msg->type) {
+        case EOG:
+            err = runtime->quiet ? UTIL : 
+                    print_winners(game->pCount, runtime->opponents);
+            break;
+        case DOWHAT:
+            if(runtime->speculated && 
+                    runtime->speculatedVersion == runtime->version) {
+                *reply = runtime->speculated;
+            } else {
+                arena_reset(game->arena); // last move has been sent
+                Budget budget = {msg->moveBudget, msg->gameBudget};
+                uint64_t start = trace_begin();
+                *reply = runtime->playerMove(game, runtime->opponents, 
+                        &budget);
+                trace_end("move", start);
+            }
+            runtime->speculated = NULL;
+            (*reply)->player = game->pID;
+            if(!runtime->quiet) {
+                fprintf(stderr, "Received dowhat\n");
+            }
+            break;
+        case TOKENS:
+            err = set_tokens(game, msg->tokens);
+            break;
+        case CARD:
+            err = table_entry(game, msg);
+            break;
+        case NEWCARD:
+            err = dealt_card(game, msg);
+            break;
+        case PURCHASED:
+            err = bought_card(game, runtime->opponents, msg);
+            break;
+        case TOOK:
+            err = took_tokens(game, msg->info, runtime->opponents, 
+                    msg->player);
+            break;
+        case WILD:
+            update_wild(game, runtime->opponents, msg->player);
+            break;
+        default:
+            err = E_COMMERR;
+    }
+    if(msg->type != DOWHAT) {
+        runtime->version++;
+    }
+    print_status(&runtime->status, game, runtime->opponents, msg->type, err);
+
+    return err;
+}
+
+/*
+ * works out the move for the view as it stands while waiting on the hub,
+ * so a dowhat with nothing before it can be answered straight away,
+ * only for move logic that depends on nothing but the view, 
+ * as the move is given no budget and may never be sent
+ * params:  runtime - players view of the game
+ */
+void runtime_speculate(Runtime* runtime) {
+    if(runtime->speculated && 
+            runtime->speculatedVersion == runtime->version) {
+        return;
+    }
+
+    Game* game = runtime->game;
+    Budget budget = {0, 0};
+    arena_reset(game->arena); // nothing from the arena is still in use
+    uint64_t start = trace_begin();
+    runtime->speculated = runtime->playerMove(game, runtime->opponents, 
+            &budget);
+    trace_end("speculate", start);
+    runtime->speculatedVersion = runtime->version;
+}
+
+/*
+ * checks if the hub has sent nothing that is still to be handled
+ * params:  input - reader over the messages of the hub
+ * returns: 1 if nothing is waiting,
+ *          0 otherwise
+ */
+int hub_idle(Reader* input) {
+    struct pollfd waiting = {input->fd, POLLIN, 0};
+    return !reader_buffered(input) && poll(&waiting, 1, 0) == 0;
+}
+
+/*
+ * frees memory used by a players view of the game, 
+ * the game itself is left to the caller
+ * params:  runtime - runtime to free
+ */
+void runtime_shred(Runtime* runtime) {
+    free(runtime->opponents);
+    arena_destroy(runtime->game->arena);
+    runtime->game->arena = NULL;
+    shred_status(&runtime->status);
+}
+
+/*
+ * main driver for logic of shenzi, banzai, and ed,
+ * reads messages from the hub and replies to dowhat on stdout,
+ * stderr is fully buffered and flushed after each move
  * params:  game - struct containing game relevant information
  *          move - function pointer to the player-specific move logic
+ *          speculate - 1: work out the move whenever the hub is quiet,
+ *                      0: only on dowhat
  * returns: E_COMMERR if bad message received,
  *          UTIL otherwise for end of game
  */
-Error play_game(Game* game, Msg* (*playerMove)(Game*, ...)) {
+Error play_game(Game* game, Msg* (*playerMove)(Game*, ...), int speculate) {
     Error err = OK;
     char* line;
     Msg msg;
+    Msg* reply;
     msg.info = (Card)malloc(sizeof(int) * CARD_SIZE);
-    Opponent* opponents = init_opponents(game->pCount);
+    Runtime runtime;
+    runtime_init(&runtime, game, playerMove, 0);
+    Reader input;
+    reader_init(&input, STDIN_FILENO);
+    static char statusBuffer[STATUS_BUFFER];
+    setvbuf(stderr, statusBuffer, _IOFBF, STATUS_BUFFER);
+    char name[ID_SIZE];
+    char process[ID_SIZE + 8];
+    sprintf(process, "player %s", player_name(game->pID, name));
+    trace_open(process, 0);
     while(err == OK && !check_signal()) {
-        line = read_line(stdin, 0, 0);
-        if(line == NULL || (int)decode_hub_msg(&msg, line) == ERR ||
-                check_signal()) {
+        line = reader_line(&input, 0, 0);
+        uint64_t start = trace_begin();
+        Comm type = line ? decode_hub_msg(&msg, line) : (Comm)ERR;
+        trace_end("decode_hub_msg", start);
+        if((int)type == ERR || check_signal()) {
             err = E_COMMERR;
             break;
         }
 
-        switch(msg.type) {
-            case EOG:
-                err = print_winners(game->pCount, opponents);
-                break;
-            case DOWHAT:
-                err = send_move(game, playerMove(game, opponents));
-                break;
-            case TOKENS:
-                err = set_tokens(game, msg.tokens);
-                break;
-            case NEWCARD:
-                err = new_card(&game->stack, msg.info);
-                break;
-            case PURCHASED:
-                err = bought_card(game, opponents, &msg);
-                break;
-            case TOOK:
-                err = took_tokens(game, msg.info, opponents, msg.player);
-                break;
-            case WILD:
-                update_wild(game, opponents, msg.player);
-                break;
-            default:
-                err = E_COMMERR;
+        err = runtime_handle(&runtime, &msg, &reply);
+        if(reply) {
+            start = trace_begin();
+            err = send_move(game, reply);
+            trace_end("send_move", start);
+        } else if(speculate && err == OK && hub_idle(&input)) {
+            runtime_speculate(&runtime);
         }
-        print_status(game, opponents, msg.type, err);
     }
     free(msg.info);
-    free(opponents);
+    runtime_shred(&runtime);
+    reader_destroy(&input);
+    fflush(stderr);
     return err;
 }
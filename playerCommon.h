@@ -7,6 +7,12 @@
 #define SHENZI 0
 #define BANZAI 1
 #define ED 2
+#define SCAR 3
+
+// size of the buffer player stderr is written through
+#define STATUS_BUFFER 65536
+// default number of moves between status prints in the every mode
+#define STATUS_EVERY_MOVES 10
 
 // struct used by players to keep track of opponents
 typedef struct {
@@ -17,6 +23,48 @@ typedef struct {
     int wild;
 } Opponent;
 
+// milliseconds a player has left to reply to a dowhat and over the game,
+// passed to the move logic after the opponents, 0 for no limit
+typedef struct {
+    int move;
+    int game;
+} Budget;
+
+// how much of the game players print to stderr after each message,
+// chosen with PLAYER_STATUS as full, off, diff or a number of moves
+typedef enum {
+    STATUS_FULL,
+    STATUS_OFF,
+    STATUS_EVERY,
+    STATUS_DIFF
+} StatusMode;
+
+// status settings and the state last printed, which diffs are taken against
+typedef struct {
+    StatusMode mode;
+    int every;
+    int moves;
+    int numCards;
+    int* board;
+    Opponent* opponents;
+} Status;
+
+// a players view of the game between messages from the hub,
+// shared by forked players and strategy plugins loaded into the hub,
+// version counts the messages that changed the view and speculated is
+// a move worked out ahead of the dowhat at speculatedVersion, NULL if none
+typedef struct {
+    Game* game;
+    Opponent* opponents;
+    Msg* (*playerMove)(Game*, ...);
+    Arena arena;
+    Status status;
+    int quiet;
+    unsigned long version;
+    Msg* speculated;
+    unsigned long speculatedVersion;
+} Runtime;
+
 int check_pcount(char* input);
 
 int check_pid(char* input, int pCount);
@@ -25,12 +73,23 @@ int* sort_by_points(int numCards, Deck deck);
 
 void init_player_game(int pID, int pCount, Game* game);
 
+void shred_player_game(Game* game);
+
 void player_status(Comm type, char* winners);
 
-Error play_game(Game* game, Msg* (*playerMove)(Game*, ...));
+void runtime_init(Runtime* runtime, Game* game, 
+        Msg* (*playerMove)(Game*, ...), int quiet);
+
+Error runtime_handle(Runtime* runtime, Msg* msg, Msg** reply);
+
+void runtime_speculate(Runtime* runtime);
+
+void runtime_shred(Runtime* runtime);
+
+Error play_game(Game* game, Msg* (*playerMove)(Game*, ...), int speculate);
 
 Error play_ed_game(Game* game, Msg* (*playerMove)(Game*, Opponent*, int));
 
-int* get_tokens(int* tokens, int tokenOrder[TOKEN_SIZE]);
+int* get_tokens(Arena* arena, int* tokens, int tokenOrder[TOKEN_SIZE]);
 
 #endif
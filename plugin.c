@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dlfcn.h>
+#include "err.h"
+#include "common.h"
+#include "comms.h"
+#include "playerCommon.h"
+#include "plugin.h"
+
+/*
+ * checks if a player argument names a plugin
+ * params:  program - player argument
+ * returns: 1 if it ends in PLUGIN_SUFFIX,
+ *          0 otherwise
+ */
+int is_plugin(char* program) {
+    size_t length = strlen(program);
+    return length > strlen(PLUGIN_SUFFIX) && 
+            !strcmp(program + length - strlen(PLUGIN_SUFFIX), PLUGIN_SUFFIX);
+}
+
+/*
+ * loads a strategy plugin into a seat
+ * params:  path - shared object to load
+ *          pCount - number of players in the game
+ *          pID - seat the plugin plays
+ * returns: NULL if the plugin cannot be loaded or initialized,
+ *          the seat otherwise
+ */
+Plugin* load_plugin(char* path, int pCount, int pID) {
+    void* library = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if(!library) {
+#ifdef TEST
+        fprintf(stderr, "dlopen:\t%s\n", dlerror());
+#endif
+        return NULL;
+    }
+    Strategy* strategy = (Strategy*)dlsym(library, PLUGIN_SYMBOL);
+    if(!strategy || strategy->abi != PLUGIN_ABI || !strategy->move) {
+        dlclose(library);
+        return NULL;
+    }
+
+    Plugin* plugin = (Plugin*)malloc(sizeof(Plugin));
+    plugin->library = library;
+    plugin->strategy = strategy;
+    plugin->msg.info = (Card)malloc(sizeof(int) * CARD_SIZE);
+    init_player_game(pID, pCount, &plugin->game);
+    runtime_init(&plugin->runtime, &plugin->game, strategy->move, 1);
+    if(strategy->init && strategy->init(&plugin->game) != OK) {
+        unload_plugin(plugin);
+        return NULL;
+    }
+
+    return plugin;
+}
+
+/*
+ * passes a message from the hub to a plugin
+ * params:  plugin - seat to pass the message to
+ *          msg - message as built by the hub
+ * returns: E_DEADPLAYER if the plugin rejects the message,
+ *          OK otherwise
+ */
+Error plugin_deliver(Plugin* plugin, Msg* msg) {
+    Msg* reply;
+    if((int)copy_hub_msg(&plugin->msg, msg) == ERR) {
+        return E_DEADPLAYER;
+    }
+    Error err = runtime_handle(&plugin->runtime, &plugin->msg, &reply);
+    if(err != OK && err != UTIL) {
+        return E_DEADPLAYER;
+    }
+
+    return OK;
+}
+
+/*
+ * asks a plugin for its move
+ * params:  plugin - seat to ask
+ *          request - dowhat as built by the hub
+ *          response - struct to save the move to, as the hub would decode it
+ * returns: ERR if the plugin gave no valid move,
+ *          type of move otherwise
+ */
+Comm plugin_move(Plugin* plugin, Msg* request, Msg* response) {
+    Msg* reply;
+    if((int)copy_hub_msg(&plugin->msg, request) != DOWHAT || 
+            runtime_handle(&plugin->runtime, &plugin->msg, &reply) != OK ||
+            !reply) {
+        return (Comm)ERR;
+    }
+
+    return copy_player_msg(response, reply);
+}
+
+/*
+ * frees a plugin seat and unloads its shared object
+ * params:  plugin - seat to free
+ */
+void unload_plugin(Plugin* plugin) {
+    if(plugin->strategy->shred) {
+        plugin->strategy->shred(&plugin->game);
+    }
+    runtime_shred(&plugin->runtime);
+    shred_player_game(&plugin->game);
+    free(plugin->msg.info);
+    dlclose(plugin->library);
+    free(plugin);
+}
@@ -0,0 +1,51 @@
+#ifndef PLUGIN_H
+#define PLUGIN_H
+
+#include "err.h"
+#include "common.h"
+#include "comms.h"
+#include "playerCommon.h"
+
+// version of the strategy plugin interface
+#define PLUGIN_ABI 2
+// name of the Strategy every plugin exports
+#define PLUGIN_SYMBOL "strategy"
+// ending of player arguments that are loaded as plugins
+#define PLUGIN_SUFFIX ".so"
+
+// exported by strategy plugins as PLUGIN_SYMBOL, 
+// move is called exactly as play_game calls it, 
+// init and shred may be NULL, and are called once per seat before
+// the first message and after the last;
+// one plugin can fill several seats, so state belongs in the game;
+// speculate is set if move depends on nothing but the game and opponents,
+// so a forked player can work it out before it is asked (see play_game)
+typedef struct {
+    int abi;
+    Error (*init)(Game* game);
+    Msg* (*move)(Game* game, ...);
+    void (*shred)(Game* game);
+    int speculate;
+} Strategy;
+
+// a seat filled by a plugin inside the hub,
+// messages are passed as structs instead of being encoded
+typedef struct Plugin {
+    void* library;
+    Strategy* strategy;
+    Game game;
+    Runtime runtime;
+    Msg msg;
+} Plugin;
+
+int is_plugin(char* program);
+
+Plugin* load_plugin(char* path, int pCount, int pID);
+
+Error plugin_deliver(Plugin* plugin, Msg* msg);
+
+Comm plugin_move(Plugin* plugin, Msg* request, Msg* response);
+
+void unload_plugin(Plugin* plugin);
+
+#endif
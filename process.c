@@ -1,93 +1,180 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
 #include <unistd.h>
+#include <errno.h>
+#include <time.h>
 #include <fcntl.h>
 #include <string.h>
+#include <spawn.h>
 #include "err.h"
 #include "common.h"
 #include "card.h"
 #include "comms.h"
 #include "hub.h"
+#include "plugin.h"
 #include "signalHandler.h"
+#include "zygote.h"
 
 /*
- * reaps player processes
- * params:  game - struct containing relevant game information
+ * collects a player process if it has exited, 
+ * keeping what it cost and reporting how it ended unless it was killed
+ * params:  player - player to collect
+ *          record - where to save the resource usage
+ *          pID - seat of the player
+ *          wait - 1: wait for the player to exit, 0: return if it has not
  *          err - if an error caused hub to kill players
+ * returns: 1 if the player is gone,
+ *          0 if it is still running
  */
-void kill_players(int pCount, Player* players, Error err) {
-    for(int i = 0; i < pCount; i++) {
-        if(players[i].toChild != NULL) {
-            fclose(players[i].toChild);
-            fclose(players[i].fromChild);
-        }
+int reap_player(Player* player, Record* record, int pID, int wait, 
+        Error err) {
+    int status = 0;
+    struct rusage usage;
+    pid_t got = wait4(player->pid, &status, wait ? 0 : WNOHANG, &usage);
+    if(!got || (got < 0 && errno == EINTR)) {
+        return 0;
+    }
+    player->pid = 0;
+    if(got < 0) { // already collected while checking the start
+        return 1;
+    }
+    record->usage = usage;
+    record->measured = 1;
 
+    char name[ID_SIZE];
+    if(err) {
+        return 1;
+    }
+    if(WIFEXITED(status) && WEXITSTATUS(status)) {
+        fprintf(stderr, "Player %s ended with status %d\n", 
+                player_name(pID, name), WEXITSTATUS(status));
+    } else if(WIFSIGNALED(status)) {
+        fprintf(stderr, "Player %s shutdown after receiving signal %d\n", 
+                player_name(pID, name), WTERMSIG(status));
+    }
+
+    return 1;
+}
+
+/*
+ * reaps player processes, players are given REAP_GRACE to exit once
+ * their pipes close and are killed after that, or straight away on error
+ * params:  pCount - number of players
+ *          players - players to reap
+ *          records - where to save the resource usage of each player
+ *          err - if an error caused hub to kill players
+ */
+void kill_players(int pCount, Player* players, Record* records, Error err) {
 #ifdef TEST
-        fprintf(stderr, "[%d]killing: player %c:%d, err:%d\n", 
-                getpid(), i + TOCHAR, players[i].pid, err);
+    fprintf(stderr, "[%d]killing: %d players, err:%d\n", 
+            getpid(), pCount, err);
 #endif
-        
-        if(err) {
-            kill(players[i].pid, SIGKILL);
-            continue;
+    release_players(pCount, players, err);
+
+    struct timespec pause = {0, REAP_POLL * 1000000L};
+    for(int waited = 0, left = 1; left; waited += REAP_POLL) {
+        left = 0;
+        for(int i = 0; i < pCount; i++) {
+            if(players[i].pid > 0 && 
+                    !reap_player(&players[i], &records[i], i, 0, err)) {
+                left++;
+            }
         }
-            
-        int status = 0;
-        dprintf(players[i].pipeOut[WRITE], "eog\n");
-        sleep(2);
-        if(!waitpid(players[i].pid, &status, WNOHANG)) {
-            kill(players[i].pid, SIGKILL);
+        if(!left) {
+            break;
+        }
+        if(waited < REAP_GRACE) {
+            nanosleep(&pause, NULL);
             continue;
         }
 
-        if(WIFEXITED(status) && WEXITSTATUS(status)) {
-            fprintf(stderr, "Player %c ended with status %d\n", 
-                    i + TOCHAR, WEXITSTATUS(status));
-            continue;
+        for(int i = 0; i < pCount; i++) { // out of time
+            if(players[i].pid > 0) {
+                kill(players[i].pid, SIGKILL);
+                while(!reap_player(&players[i], &records[i], i, 1, err)) {
+                }
+            }
         }
+    }
+}
 
-        if(WIFSIGNALED(status)) {
-            fprintf(stderr, "Player %c shutdown after receiving signal %d\n", 
-                    i + TOCHAR, WTERMSIG(status));
+/*
+ * lets go of players without waiting for them to exit, 
+ * they are killed if an error ended the game
+ * params:  pCount - number of players
+ *          players - players to let go of
+ *          err - if an error caused hub to release players
+ */
+void release_players(int pCount, Player* players, Error err) {
+    for(int i = 0; i < pCount; i++) {
+        if(players[i].plugin) {
+            unload_plugin(players[i].plugin);
+            players[i].plugin = NULL;
             continue;
         }
+
+        if(players[i].toChild != NULL) {
+            fclose(players[i].toChild);
+            close(players[i].fromChild.fd);
+            reader_destroy(&players[i].fromChild);
+            players[i].toChild = NULL;
+        } else if(players[i].pipeIn[READ] >= 0) { // never opened
+            close(players[i].pipeIn[READ]);
+            close(players[i].pipeOut[WRITE]);
+        }
+        players[i].pipeIn[READ] = -1;
+        if(err && players[i].pid > 0) {
+            kill(players[i].pid, SIGKILL);
+        }
     }
 }
 
 /*
- * sets up piping for parent or child
- * params:  player - struct containing player pipes
- *          type - char of either 'p': parent or 'c': child
+ * caps the resources of a player once it is started, 
+ * running out of cpu time ends it with SIGXCPU, or SIGKILL a second later
+ * params:  options - hub options holding the caps
+ *          pid - the player, 0 for the calling process
  */
-void pipe_setup(Player* player, char type) {
-    if(type == 'p') { // parent
-        close(player->pipeIn[WRITE]);
-        close(player->pipeOut[READ]);
-    } else { // child
-        dup2(player->pipeOut[READ], STDIN_FILENO);
-        dup2(player->pipeIn[WRITE], STDOUT_FILENO);
-        close(STDERR_FILENO);
-        close(player->pipeIn[READ]);
-        close(player->pipeIn[WRITE]);
-        close(player->pipeOut[READ]);
-        close(player->pipeOut[WRITE]);
+void limit_player(Options* options, pid_t pid) {
+    if(options->cpuLimit) {
+        struct rlimit limit = {(rlim_t)options->cpuLimit, 
+                (rlim_t)options->cpuLimit + 1};
+        prlimit(pid, RLIMIT_CPU, &limit, NULL);
+    }
+    if(options->memoryLimit) {
+        rlim_t bytes = (rlim_t)options->memoryLimit << 20;
+        struct rlimit limit = {bytes, bytes};
+        prlimit(pid, RLIMIT_AS, &limit, NULL);
     }
 }
 
 /*
- * starts pipes for players
+ * closes the ends of a player's pipes that belong to the player
+ * once it has them
+ * params:  player - struct containing player pipes
+ */
+void pipe_setup(Player* player) {
+    close(player->pipeIn[WRITE]);
+    close(player->pipeOut[READ]);
+}
+
+/*
+ * starts pipes for players, no end is inherited through an exec,
+ * the player's ends are duplicated onto its stdin and stdout
  * params:  player - player to initialize pipes for
  * returns: E_EXEC if pipe failed,
  *          OK otherwise
  */
 Error init_pipe(Player* player) {
-    if(pipe(player->pipeIn) < 0) {
+    if(pipe2(player->pipeIn, O_CLOEXEC) < 0) {
         return E_EXEC;
     }
 
-    if(pipe(player->pipeOut) < 0) {
+    if(pipe2(player->pipeOut, O_CLOEXEC) < 0) {
         close(player->pipeIn[READ]);
         close(player->pipeIn[WRITE]);
         return E_EXEC;
@@ -97,14 +184,17 @@ Error init_pipe(Player* player) {
 }
 
 /*
- * makes the exec parameters and execs
- * params:  pCount - number of players
+ * execs a player on its pipes with posix_spawn, which neither copies 
+ * the hub nor returns before the exec, so a failed exec is known here,
+ * the player has no stderr
+ * params:  player - player to exec, its pid is saved here
+ *          pCount - number of players
  *          pID - this players id
- *          players - function to exec
- * returns: should not return anything
- *          E_EXEC if exec failed
+ *          players - player programs
+ * returns: errno of the failed spawn or exec,
+ *          0 otherwise
  */
-Error make_exec(int pCount, int pID, char** players) {
+int make_exec(Player* player, int pCount, int pID, char** players) {
     char* totalPlayers = to_string(pCount);
     char* playerNum = to_string(pID);
     char* args[] = {players[pID], totalPlayers, playerNum, NULL};
@@ -113,96 +203,170 @@ Error make_exec(int pCount, int pID, char** players) {
     fprintf(stderr, "exec:\t%s %s %s\n", args[0], args[1], args[2]);
 #endif
 
-    execvp(args[0], args);
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, player->pipeOut[READ], 
+            STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, player->pipeIn[WRITE], 
+            STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&actions, STDERR_FILENO);
+    int failed = posix_spawnp(&player->pid, args[0], &actions, NULL, args, 
+            environ);
+    posix_spawn_file_actions_destroy(&actions);
     free(totalPlayers);
     free(playerNum);
-    return E_EXEC;
+    return failed;
 }
 
 /*
- * checks if all players started successfully, opens files if so
- * params:  pCount - number of players to start
+ * opens the pipes of the players for the hub
+ * params:  pCount - number of players
  *          session - struct containing hub only information
- * returns: E_EXEC if players failed,
- *          OK otherwise
  */
-Error check_player_start(int pCount, Session* session) {
-    sleep(1); // wait for failed exec to return
-    for(int i = 0; i < pCount; i++) { // check if exec succeeded
-        int status = 0;
-        int returnPID = waitpid(session->players[i].pid, &status, WNOHANG);
-        if(returnPID != 0) {
-#ifdef TEST
-            printf("%c exited prematurely, status:%d\n", 
-                    i + TOCHAR, WEXITSTATUS(status));
-#endif
-            session->players[i].toChild = NULL;
-            session->players[i].fromChild = NULL;
-            return E_EXEC;
+void open_players(int pCount, Session* session) {
+    for(int i = 0; i < pCount; i++) {
+        if(session->players[i].plugin) {
+            continue;
         }
-        
+
         session->players[i].toChild = 
                 fdopen(session->players[i].pipeOut[WRITE], "w");
-        session->players[i].fromChild = 
-                fdopen(session->players[i].pipeIn[READ], "r");
-
-#ifdef TEST
-        char* line = read_line(session->players[i].fromChild, 1, 1);
-        printf("child %c announcing: %s", i + TOCHAR, line);
-        free(line);
-#endif
+        setvbuf(session->players[i].toChild, NULL, _IOFBF, PIPE_BUFFER);
+        reader_init(&session->players[i].fromChild, 
+                session->players[i].pipeIn[READ]);
     }
+}
 
-    return OK;
+/*
+ * sets up the state of every player for a new game, all zeroed
+ * params:  state - state to set up
+ *          pCount - number of players
+ */
+void init_player_state(PlayerState* state, int pCount) {
+    int* block = (int*)calloc((size_t)pCount * (2 + 2 * TOKEN_SIZE), 
+            sizeof(int));
+    state->points = block;
+    state->wild = block + pCount;
+    state->discount = (int (*)[TOKEN_SIZE])(block + 2 * pCount);
+    state->ownedTokens = (int (*)[TOKEN_SIZE])(block + 
+            (2 + TOKEN_SIZE) * pCount);
 }
 
 /*
- * starts the given players
+ * frees the state of the players
+ * params:  state - state to free
+ */
+void shred_player_state(PlayerState* state) {
+    free(state->points);
+    state->points = NULL;
+}
+
+/*
+ * raises the open file limit as far as allowed when the hub needs 
+ * more descriptors than it gives, every player on a pipe needs 4 while
+ * it starts and 2 once it is running
+ * params:  pCount - number of players to start
+ */
+void raise_fd_limit(int pCount) {
+    struct rlimit limit;
+    rlim_t needed = (rlim_t)pCount * 4 + FD_SPARE;
+    if(getrlimit(RLIMIT_NOFILE, &limit) || limit.rlim_cur >= needed) {
+        return;
+    }
+    limit.rlim_cur = limit.rlim_max < needed ? limit.rlim_max : needed;
+    setrlimit(RLIMIT_NOFILE, &limit);
+}
+
+/*
+ * starts the given players with posix_spawn without waiting to see them
+ * start, loads plugins in process, or has the zygote fork them when it
+ * can play the program, a player whose spawn fails is reported and skipped
  * params:  pCount - number of players to start
  *          players - array of player commands to exec
  *          game - struct containing relevant game information
  *          session - struct containing hub only information
- * returns: E_EXEC if any players did not start successfully,
+ * returns: E_EXEC if any players could not be started,
  *          OK otherwise
  */
-Error start_players(int pCount, char** players, Game* game, Session* session) {
+Error spawn_players(int pCount, char** players, Game* game, 
+        Session* session) {
     session->parentPID = getpid();
-    session->playerStats = (Game*)malloc(sizeof(Game) * pCount);
+    init_player_state(&session->state, pCount);
     session->players = (Player*)malloc(sizeof(Player) * pCount);
+    session->records = (Record*)calloc(pCount, sizeof(Record));
+    session->programs = players;
+    session->rounds = 0;
+    Error err = OK;
     for(int i = 0; i < pCount; i++, game->pCount++) {
-        if(init_pipe(&session->players[i]) != OK) {
-            return E_EXEC;
+        session->players[i].toChild = NULL;
+        session->players[i].plugin = NULL;
+        session->players[i].zygote = 0;
+        if(is_plugin(players[i])) { // runs inside the hub, no process
+            session->players[i].pid = 0;
+            session->players[i].plugin = load_plugin(players[i], pCount, i);
+            if(!session->players[i].plugin) {
+                return E_EXEC;
+            }
+            continue;
         }
 
-        session->playerStats[i].pID = i;
-        session->playerStats[i].numPoints = 0;
-        memset(session->playerStats[i].discount, 
-                0, sizeof(int) * TOKEN_SIZE);
-        memset(session->playerStats[i].ownedTokens, 
-                0, sizeof(int) * TOKEN_SIZE);
-        session->playerStats[i].wild = 0;
-
-        pid_t pid = fork();
-        
-        if(pid < 0) { // failed to fork
+        if(init_pipe(&session->players[i]) != OK) {
             return E_EXEC;
         }
-        
-        if(pid == 0) { // child
-            pipe_setup(&session->players[i], 'c');
-#ifdef TEST
-            printf("child %d started\n", getpid());
-            fflush(stdout);
-#endif
-            return make_exec(pCount, i, players); // should not return
-        } 
-        
-        if(pid > 0) { // parent
+
+        pid_t pid = zygote_spawn(players[i], pCount, i, 
+                session->players[i].pipeOut[READ], 
+                session->players[i].pipeIn[WRITE]);
+        if(pid > 0) { // forked ready to play, nothing left to exec
             session->players[i].pid = pid;
-            pipe_setup(&session->players[i], 'p');
+            session->players[i].zygote = 1;
+            pipe_setup(&session->players[i]);
+            continue;
         }
+
+        int failed = make_exec(&session->players[i], pCount, i, players);
+        pipe_setup(&session->players[i]);
+        if(failed) {
+            char name[ID_SIZE];
+            fprintf(stderr, "Player %s could not be started: %s\n", 
+                    player_name(i, name), strerror(failed));
+            close(session->players[i].pipeIn[READ]);
+            close(session->players[i].pipeOut[WRITE]);
+            session->players[i].pid = 0;
+            session->players[i].pipeIn[READ] = -1;
+            err = E_EXEC;
+            continue;
+        }
+        if(session->options) {
+            place_player(session->options->placement, 
+                    session->players[i].pid, i, pCount);
+            limit_player(session->options, session->players[i].pid);
+        }
+    }
+    if(session->options) {
+        report_placement(session->options->placement, pCount);
     }
 
-    return check_player_start(pCount, session);
+    return err;
+}
+
+/*
+ * starts the given players
+ * params:  pCount - number of players to start
+ *          players - array of player commands to exec
+ *          game - struct containing relevant game information
+ *          session - struct containing hub only information
+ * returns: E_EXEC if any players did not start successfully,
+ *          OK otherwise
+ */
+Error start_players(int pCount, char** players, Game* game, Session* session) {
+    raise_fd_limit(pCount);
+    Error err = spawn_players(pCount, players, game, session);
+    if(err) {
+        return err;
+    }
+    open_players(pCount, session);
+
+    return OK;
 }
 
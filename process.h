@@ -1,29 +1,114 @@
 #ifndef PROCESS_H
 #define PROCESS_H
 
+#include <stdint.h>
 #include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
 #include "err.h"
 #include "common.h"
+#include "reader.h"
+#include "options.h"
 
-// information used by hub for communication to players
+// defined in plugin.h, only the hub sources that run plugins need it
+struct Plugin;
+
+// size of the buffer messages to each player wait in until flushed
+#define PIPE_BUFFER 65536
+// descriptors kept free for the hub itself
+#define FD_SPARE 32
+// milliseconds players get to exit once their pipes close
+#define REAP_GRACE 2000
+// milliseconds between checks on players that have not exited yet
+#define REAP_POLL 1
+// rounds without progress a game gets beyond what its dearest card costs
+#define STALL_ROUNDS 16
+// FNV-1a offset basis and prime the game fingerprint is hashed with
+#define FINGERPRINT_BASIS 0xcbf29ce484222325ULL
+#define FINGERPRINT_PRIME 0x100000001b3ULL
+// milliseconds a reply may arrive past the budget of the move
+#define BUDGET_GRACE 50
+
+// information used by hub for communication to players,
+// players loaded as plugins have no process or pipes,
+// players forked by the zygote were never exec'd
 typedef struct {
     pid_t pid;
+    int zygote;
     int pipeIn[2];
     int pipeOut[2];
     FILE* toChild;
-    FILE* fromChild;
+    Reader fromChild;
+    struct Plugin* plugin;
 } Player;
 
+// per player counts kept by the hub for the result record,
+// usage is what the player process cost, measured once it is reaped,
+// thought is the nanoseconds it has taken over its moves
+typedef struct {
+    int wilds;
+    int cards;
+    int measured;
+    struct rusage usage;
+    uint64_t thought;
+} Record;
+
+// what the hub tracks of every player, held as a column per field
+// with a row per player, so a scan over one field such as the points in
+// check_win reads consecutive ints, all columns share one allocation
+typedef struct {
+    int* points;
+    int* wild;
+    int (*discount)[TOKEN_SIZE];
+    int (*ownedTokens)[TOKEN_SIZE];
+} PlayerState;
+
 // hub only information, contains player communication,
-// player stats and the parentPID for identification
+// player state and the parentPID for identification,
+// programs, rounds and records describe the game for the result record,
+// turn is the player whose move is awaited, attempt how often it was asked
+// and prompted when it was last asked, deadline when its reply is too late,
+// 0 without a budget,
+// fingerprint sums up what has been achieved by the end of the last round
+// and stalled counts the rounds it has not changed for,
+// job is the line of the jobs file the game was read from, 0 for none
 typedef struct {
     int id;
     pid_t parentPID;
     Player* players;
-    Game* playerStats;
+    PlayerState state;
+    Options* options;
+    char** programs;
+    int rounds;
+    Record* records;
+    int turn;
+    int attempt;
+    uint64_t prompted;
+    uint64_t deadline;
+    uint64_t fingerprint;
+    int stalled;
+    int job;
 } Session;
 
-void kill_players(int pCount, Player* players, Error err);
+int reap_player(Player* player, Record* record, int pID, int wait, 
+        Error err);
+
+void kill_players(int pCount, Player* players, Record* records, Error err);
+
+void release_players(int pCount, Player* players, Error err);
+
+void limit_player(Options* options, pid_t pid);
+
+void init_player_state(PlayerState* state, int pCount);
+
+void shred_player_state(PlayerState* state);
+
+void raise_fd_limit(int pCount);
+
+void open_players(int pCount, Session* session);
+
+Error spawn_players(int pCount, char** players, Game* game, 
+        Session* session);
 
 Error start_players(int pCount, char** players, Game* game, Session* session);
 
@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "reader.h"
+
+/*
+ * initializes a reader for the given file descriptor
+ * params:  reader - reader to initialize
+ *          fd - file descriptor to read from
+ */
+void reader_init(Reader* reader, int fd) {
+    reader->fd = fd;
+    reader->size = READER_SIZE;
+    reader->buffer = (char*)malloc(sizeof(char) * reader->size);
+    reader->start = 0;
+    reader->end = 0;
+}
+
+/*
+ * refills the buffer with a single read, 
+ * moving unconsumed bytes to the front and growing if the buffer is full
+ * params:  reader - reader to refill
+ * returns: number of bytes read, 0 on EOF, -1 on error
+ */
+int reader_fill(Reader* reader) {
+    if(reader->start > 0) {
+        memmove(reader->buffer, reader->buffer + reader->start, 
+                reader->end - reader->start);
+        reader->end -= reader->start;
+        reader->start = 0;
+    }
+
+    if(reader->end >= reader->size - 1) { // keep room for a terminator
+        reader->size *= 2;
+        reader->buffer = (char*)realloc(reader->buffer, 
+                sizeof(char) * reader->size);
+    }
+
+    int count = (int)read(reader->fd, reader->buffer + reader->end, 
+            reader->size - reader->end - 1);
+    if(count > 0) {
+        reader->end += count;
+    }
+
+    return count;
+}
+
+/*
+ * hands out the next line without copying it, the line points into the
+ * readers buffer and is only valid until the next call
+ * params:  reader - reader to read from
+ *          space - 1: allow, 0: deny
+ *          newline - 1: allow, 0: replace
+ * returns: string ending with a newline 
+ *          (replacing newline with a null terminator),
+ *          null if EOF, a read error, or a denied space is encountered
+ */
+char* reader_line(Reader* reader, int space, int newline) {
+    int scanned = 0; // bytes after start known not to hold a newline
+    char* found = NULL;
+    while(1) {
+        char* from = reader->buffer + reader->start + scanned;
+        int available = reader->end - reader->start - scanned;
+        found = (char*)memchr(from, '\n', available);
+        int length = found ? (int)(found - from) : available;
+        if(!space && memchr(from, ' ', length)) {
+            return NULL;
+        }
+
+        if(found) {
+            break;
+        }
+
+        scanned += length;
+        if(reader_fill(reader) <= 0) {
+            return NULL;
+        }
+    }
+
+    char* line = reader->buffer + reader->start;
+    int position = (int)(found - reader->buffer);
+    if(newline) { // the terminator goes after the newline
+        if(position + 1 == reader->end) {
+            found[1] = '\0';
+        } else { // the next line starts straight after, shift it along
+            memmove(found + 2, found + 1, reader->end - position - 1);
+            found[1] = '\0';
+            reader->end++;
+            position++;
+        }
+    } else {
+        found[0] = '\0';
+    }
+    reader->start = position + 1;
+
+    return line;
+}
+
+/*
+ * checks if a whole line is waiting in the buffer, 
+ * so reader_line can return it without reading
+ * params:  reader - reader to check
+ * returns: 1 if a line is buffered,
+ *          0 otherwise
+ */
+int reader_has_line(Reader* reader) {
+    return memchr(reader->buffer + reader->start, '\n', 
+            reader->end - reader->start) != NULL;
+}
+
+/*
+ * checks if lines have already been read and are waiting in the buffer
+ * params:  reader - reader to check
+ * returns: number of unconsumed bytes
+ */
+int reader_buffered(Reader* reader) {
+    return reader->end - reader->start;
+}
+
+/*
+ * frees the readers buffer, the file descriptor is left open
+ * params:  reader - reader to destroy
+ */
+void reader_destroy(Reader* reader) {
+    free(reader->buffer);
+    reader->buffer = NULL;
+}
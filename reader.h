@@ -0,0 +1,29 @@
+#ifndef READER_H
+#define READER_H
+
+// initial size of the buffer owned by each reader
+#define READER_SIZE 16384
+
+// buffered line reader over a file descriptor,
+// bytes between start and end have been read but not handed out
+typedef struct {
+    int fd;
+    char* buffer;
+    int size;
+    int start;
+    int end;
+} Reader;
+
+void reader_init(Reader* reader, int fd);
+
+int reader_fill(Reader* reader);
+
+char* reader_line(Reader* reader, int space, int newline);
+
+int reader_has_line(Reader* reader);
+
+int reader_buffered(Reader* reader);
+
+void reader_destroy(Reader* reader);
+
+#endif
@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "err.h"
+#include "common.h"
+#include "process.h"
+#include "result.h"
+
+/*
+ * names the way a game ended
+ * params:  err - code the game ended with
+ * returns: name of the status
+ */
+char* result_status(Error err) {
+    switch(err) {
+        case OK:
+            return "finished";
+        case E_PROTOCOL:
+            return "protocol";
+        case E_DEADPLAYER:
+            return "disconnected";
+        case E_SIGINT:
+            return "interrupted";
+        case E_ABORTED:
+            return "aborted";
+        case E_TIMEOUT:
+            return "timeout";
+        default:
+            return "error";
+    }
+}
+
+/*
+ * converts a time to microseconds
+ * params:  time - time to convert
+ * returns: microseconds
+ */
+long long time_micros(struct timeval* time) {
+    return (long long)time->tv_sec * 1000000 + time->tv_usec;
+}
+
+/*
+ * prints what each player process cost to stderr
+ * params:  game - struct containing relevant game information
+ *          session - struct containing hub only information
+ */
+void report_usage(Game* game, Session* session) {
+    for(int i = 0; i < game->pCount; i++) {
+        struct rusage* usage = &session->records[i].usage;
+        if(!session->records[i].measured) {
+            continue;
+        }
+        char name[ID_SIZE];
+        fprintf(stderr, "Player %s used %.3fs user %.3fs system, "
+                "%ldKB max rss, %ld voluntary %ld involuntary switches\n", 
+                player_name(i, name), time_micros(&usage->ru_utime) / 1e6,
+                time_micros(&usage->ru_stime) / 1e6, usage->ru_maxrss,
+                usage->ru_nvcsw, usage->ru_nivcsw);
+    }
+}
+
+/*
+ * appends the result record of the game to the result file,
+ * the record is written in one piece so parallel hubs can share a file,
+ * a game from a jobs file ends it with the line number of its job
+ * params:  game - struct containing relevant game information
+ *          session - struct containing hub only information
+ *          err - code the game ended with
+ * returns: ERR if the result file cannot be written,
+ *          OK otherwise
+ */
+Error write_result(Game* game, Session* session, Error err) {
+    if(!session->options || !session->options->resultFile) {
+        return OK;
+    }
+    FILE* results = fopen(session->options->resultFile, "a");
+    if(!results) {
+        return ERR;
+    }
+    setvbuf(results, NULL, _IOFBF, BUFSIZ * 4);
+
+    fprintf(results, "%s %s %d %d", RESULT_TAG, result_status(err),
+            session->rounds, game->pCount);
+    for(int i = 0; i < game->pCount; i++) {
+        int points = session->state.points[i];
+        fprintf(results, " %s:%d:%d:%d:%d", session->programs[i],
+                points, session->records[i].wilds, 
+                session->records[i].cards, 
+                err == OK && points >= game->numPoints);
+    }
+    for(int i = 0; i < game->pCount; i++) {
+        struct rusage* usage = &session->records[i].usage;
+        if(!session->records[i].measured) {
+            fprintf(results, " -");
+            continue;
+        }
+        fprintf(results, " %lld:%lld:%ld:%ld:%ld", 
+                time_micros(&usage->ru_utime), time_micros(&usage->ru_stime),
+                usage->ru_maxrss, usage->ru_nvcsw, usage->ru_nivcsw);
+    }
+    if(session->job) {
+        fprintf(results, " %d", session->job);
+    }
+    fprintf(results, "\n");
+    
+    return fclose(results) ? ERR : OK;
+}
@@ -0,0 +1,25 @@
+#ifndef RESULT_H
+#define RESULT_H
+
+#include "err.h"
+#include "common.h"
+#include "process.h"
+
+// every game appends one line to the result file,
+// game status rounds pcount program:points:wilds:cards:won [...] 
+// user:system:maxrss:voluntary:involuntary [...]
+// with a field for each seat in turn order, then the cost of each seat:
+// cpu time in microseconds, max rss in kilobytes and context switches,
+// or - for a seat with no process of its own,
+// and for a game from a jobs file the line number of its job;
+// status is finished, protocol, disconnected, interrupted, aborted,
+// timeout or error
+#define RESULT_TAG "game"
+
+char* result_status(Error err);
+
+Error write_result(Game* game, Session* session, Error err);
+
+void report_usage(Game* game, Session* session);
+
+#endif
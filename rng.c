@@ -0,0 +1,48 @@
+#include <stdint.h>
+#include "rng.h"
+
+/*
+ * scrambles the bits of the given value (splitmix64 finalizer)
+ * params:  input - value to scramble
+ * returns: scrambled value
+ */
+uint64_t mix64(uint64_t input) {
+    input += 0x9E3779B97F4A7C15ULL;
+    input = (input ^ (input >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    input = (input ^ (input >> 27)) * 0x94D049BB133111EBULL;
+    return input ^ (input >> 31);
+}
+
+/*
+ * seeds the generator, the same seed always gives the same sequence
+ * params:  rng - generator to seed
+ *          seed - any value, including 0
+ */
+void rng_seed(Rng* rng, uint64_t seed) {
+    rng->state = mix64(seed);
+    if(!rng->state) { // xorshift never leaves the zero state
+        rng->state = 0x9E3779B97F4A7C15ULL;
+    }
+}
+
+/*
+ * advances the generator
+ * params:  rng - generator to advance
+ * returns: next 64 bit pseudo random value
+ */
+uint64_t rng_next(Rng* rng) {
+    rng->state ^= rng->state >> 12;
+    rng->state ^= rng->state << 25;
+    rng->state ^= rng->state >> 27;
+    return rng->state * 0x2545F4914F6CDD1DULL;
+}
+
+/*
+ * picks a pseudo random number in a range
+ * params:  rng - generator to use
+ *          bound - upper bound of the range (exclusive), must be positive
+ * returns: number from 0 to bound - 1
+ */
+int rng_range(Rng* rng, int bound) {
+    return (int)((rng_next(rng) >> 32) * (uint64_t)bound >> 32);
+}
@@ -0,0 +1,19 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// state of a seedable pseudo random number generator (xorshift64*)
+typedef struct {
+    uint64_t state;
+} Rng;
+
+void rng_seed(Rng* rng, uint64_t seed);
+
+uint64_t rng_next(Rng* rng);
+
+int rng_range(Rng* rng, int bound);
+
+uint64_t mix64(uint64_t input);
+
+#endif
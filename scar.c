@@ -0,0 +1,615 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include "err.h"
+#include "common.h"
+#include "playerCommon.h"
+#include "comms.h"
+#include "card.h"
+#include "token.h"
+#include "arena.h"
+#include "rng.h"
+#include "moves.h"
+#include "zobrist.h"
+#include "signalHandler.h"
+
+// default time allowed for each move in milliseconds
+#define DEFAULT_BUDGET 100
+// default number of search threads
+#define DEFAULT_THREADS 2
+// maximum number of search threads
+#define MAX_THREADS 16
+// time kept back from the budget for replying to the hub, in milliseconds
+#define REPLY_MARGIN 5
+// moves what is left of a game budget is spread over
+#define GAME_SHARE 20
+// rounds simulated past the end of the tree before scoring
+#define ROLLOUT_ROUNDS 2
+// maximum depth of the tree in plies
+#define MAX_DEPTH 64
+// size of each block of node memory
+#define NODE_BLOCK (1 << 20)
+// weight of exploration against exploitation when selecting nodes
+#define EXPLORATION 1.4
+
+// node of the search tree, score is from the perspective of the mover,
+// key is the hash of the position after the move and the player to move
+// next, set once it is played and used to share results in the table
+typedef struct Node {
+    Move move;
+    uint64_t key;
+    int mover;
+    int visits;
+    double score;
+    int numChildren;
+    struct Node* children;
+} Node;
+
+// state owned by a single search thread,
+// game and opponents are scratch copies of the root position,
+// moves played on them are taken back through undo after each iteration
+typedef struct {
+    int id;
+    Game* rootGame;
+    Opponent* rootOpponents;
+    Game game;
+    Opponent* opponents;
+    int* cards;
+    double* rewards;
+    Node* path[MAX_DEPTH + 1];
+    Undo* undo;
+    Arena arena;
+    Rng rng;
+    Node* root;
+    long long deadline;
+    long nodes;
+    TransCounts counts;
+    pthread_t thread;
+} Worker;
+
+// search settings and threads, kept between moves,
+// results of every position searched are shared by the threads in table
+typedef struct {
+    int budget;
+    int numThreads;
+    unsigned long long seed;
+    int moves;
+    Worker* workers;
+    TransTable table;
+} Search;
+
+Search search = {DEFAULT_BUDGET, DEFAULT_THREADS, 0, 0, NULL, {NULL, 0}};
+
+/*
+ * lists every legal move for a player
+ * params:  game - position to generate moves for
+ *          player - stats of the player to move
+ *          moves - array of at least MAX_MOVES to save moves into
+ * returns: number of moves saved, purchases first and wild last
+ */
+int player_moves(Game* game, Opponent* player, Move* moves) {
+    return legal_moves(game->tokens, &game->stack, player->discount, 
+            player->tokens, player->wild, moves);
+}
+
+/*
+ * copies the root position into the workers scratch position
+ * params:  worker - worker to reset
+ */
+void restore_position(Worker* worker) {
+    Game* root = worker->rootGame;
+    memcpy(worker->game.tokens, root->tokens, sizeof(int) * TOKEN_SIZE);
+    worker->game.stack.numCards = root->stack.numCards < BOARD_SIZE ?
+            root->stack.numCards : BOARD_SIZE;
+    for(int i = 0; i < worker->game.stack.numCards; i++) {
+        worker->game.stack.deck[i] = worker->cards + i * CARD_SIZE;
+        memcpy(worker->game.stack.deck[i], root->stack.deck[i],
+                sizeof(int) * CARD_SIZE);
+    }
+    memcpy(worker->opponents, worker->rootOpponents,
+            sizeof(Opponent) * root->pCount);
+}
+
+#ifdef TEST
+/*
+ * checks that undoing every move of an iteration left the scratch 
+ * position exactly as restore_position made it
+ * params:  worker - worker to check
+ */
+void check_restored(Worker* worker) {
+    Game* root = worker->rootGame;
+    int same = !memcmp(worker->game.tokens, root->tokens, 
+            sizeof(int) * TOKEN_SIZE) && !memcmp(worker->opponents, 
+            worker->rootOpponents, sizeof(Opponent) * root->pCount);
+    for(int i = 0; i < worker->game.stack.numCards; i++) {
+        same = same && worker->game.stack.deck[i] == 
+                worker->cards + i * CARD_SIZE && 
+                !memcmp(worker->game.stack.deck[i], root->stack.deck[i], 
+                sizeof(int) * CARD_SIZE);
+    }
+    if(!same || worker->game.stack.numCards != (root->stack.numCards < 
+            BOARD_SIZE ? root->stack.numCards : BOARD_SIZE)) {
+        fprintf(stderr, "worker %d position not restored\n", worker->id);
+    }
+}
+#endif
+
+/*
+ * creates the children of a node, one for each legal move
+ * params:  worker - worker owning the node
+ *          node - node to expand, its move must already be played
+ * returns: ERR if out of memory,
+ *          OK otherwise
+ */
+Error expand_node(Worker* worker, Node* node) {
+    Move moves[MAX_MOVES];
+    int mover = (node->mover + 1) % worker->game.pCount;
+    int count = player_moves(&worker->game, &worker->opponents[mover], moves);
+    Node* children = (Node*)arena_alloc(&worker->arena, sizeof(Node) * count);
+    if(!children) {
+        return ERR;
+    }
+
+    for(int i = 0; i < count; i++) {
+        children[i].move = moves[i];
+        children[i].mover = mover;
+        children[i].visits = 0;
+        children[i].score = 0;
+        children[i].numChildren = -1;
+        children[i].children = NULL;
+    }
+    node->children = children;
+    node->numChildren = count;
+    return OK;
+}
+
+/*
+ * gives the key of the player to move next, positions are only the 
+ * same if the same player moves next
+ * params:  mover - player who made the last move
+ *          pCount - number of players
+ * returns: 64 bit key of the next player
+ */
+uint64_t mover_key(int mover, int pCount) {
+    return zobrist_key(ZOBRIST_MOVER, 0, (mover + 1) % pCount);
+}
+
+/*
+ * picks the child to explore using the UCT formula,
+ * a child's position reached more often through other paths or 
+ * threads is valued by the results in the table instead,
+ * unvisited children are always tried first
+ * params:  worker - worker owning the node
+ *          node - expanded node to choose from
+ * returns: chosen child
+ */
+Node* select_child(Worker* worker, Node* node) {
+    Node* best = &node->children[0];
+    double bestValue = -1;
+    double logVisits = log((double)node->visits + 1);
+    int offset = rng_range(&worker->rng, node->numChildren);
+    for(int i = 0; i < node->numChildren; i++) {
+        Node* child = &node->children[(i + offset) % node->numChildren];
+        if(!child->visits) {
+            return child;
+        }
+
+        double mean = child->score / child->visits;
+        int visits;
+        double score;
+        if(trans_probe(&search.table, &worker->counts, child->key, 
+                child->visits, &visits, &score)) { // reached by other paths
+            mean = score / visits;
+        }
+        double value = mean + EXPLORATION * sqrt(logVisits / child->visits);
+        if(value > bestValue) {
+            bestValue = value;
+            best = child;
+        }
+    }
+
+    return best;
+}
+
+/*
+ * chooses a move during a rollout, purchases are strongly preferred
+ * params:  worker - worker running the rollout
+ *          moves - legal moves, purchases first
+ *          count - number of legal moves
+ * returns: index of the chosen move
+ */
+int rollout_choice(Worker* worker, Move* moves, int count) {
+    if(moves[0].type == PURCHASE && rng_range(&worker->rng, 4)) {
+        int best = 0;
+        for(int i = 1; i < count && moves[i].type == PURCHASE; i++) {
+            if(worker->game.stack.deck[moves[i].card][POINTS] >
+                    worker->game.stack.deck[moves[best].card][POINTS]) {
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    return rng_range(&worker->rng, count);
+}
+
+/*
+ * values a players standing, points first then the means to earn them
+ * params:  player - stats of the player
+ * returns: heuristic value of the player
+ */
+double player_value(Opponent* player) {
+    double value = player->numPoints;
+    for(int i = 0; i < TOKEN_SIZE; i++) {
+        value += 0.2 * player->discount[i] + 0.05 * player->tokens[i];
+    }
+
+    return value + 0.05 * player->wild;
+}
+
+/*
+ * scores the scratch position for every player,
+ * rewards are between 0 and 1 depending on the lead over the best opponent
+ * params:  worker - worker owning the position
+ */
+void score_position(Worker* worker) {
+    int pCount = worker->game.pCount;
+    double first = -1, second = -1;
+    for(int i = 0; i < pCount; i++) {
+        double value = player_value(&worker->opponents[i]);
+        worker->rewards[i] = value;
+        if(value > first) {
+            second = first;
+            first = value;
+        } else if(value > second) {
+            second = value;
+        }
+    }
+
+    for(int i = 0; i < pCount; i++) {
+        double lead = worker->rewards[i] -
+                (worker->rewards[i] == first ? second : first);
+        worker->rewards[i] = 0.5 + 0.5 * lead / (fabs(lead) + 2);
+    }
+}
+
+#ifdef TEST
+/*
+ * checks that the hash kept up move by move matches the hash of 
+ * the scratch position worked out from scratch
+ * params:  worker - worker to check
+ *          node - node whose move was just played
+ */
+void check_key(Worker* worker, Node* node) {
+    int pCount = worker->game.pCount;
+    if(node->key != zobrist_position(&worker->game, worker->opponents, 
+            pCount) + mover_key(node->mover, pCount)) {
+        fprintf(stderr, "worker %d hash out of step\n", worker->id);
+    }
+}
+#endif
+
+/*
+ * plays the move of a node on the scratch position, the key of the
+ * node is worked out from its parent the first time it is played
+ * params:  worker - worker owning the position
+ *          parent - node the position is at
+ *          node - child of parent to play
+ *          undo - where to save what undo_move needs
+ */
+void play_node(Worker* worker, Node* parent, Node* node, Undo* undo) {
+    Opponent* mover = &worker->opponents[node->mover];
+    int pCount = worker->game.pCount;
+    if(!node->visits) {
+        node->key = zobrist_move(parent->key - 
+                mover_key(parent->mover, pCount), &worker->game, mover, 
+                &node->move) + mover_key(node->mover, pCount);
+    }
+    apply_move(&worker->game, mover, &node->move, undo);
+}
+
+/*
+ * runs one iteration of the search: selection, expansion,
+ * rollout and backpropagation
+ * params:  worker - worker to search with
+ */
+void search_iteration(Worker* worker) {
+    int pCount = worker->game.pCount;
+    int depth = 0;
+    int played = 0;
+    Node* node = worker->root;
+    worker->path[depth] = node;
+
+    while(node->numChildren > 0 && depth < MAX_DEPTH) { // selection
+        node = select_child(worker, node);
+        play_node(worker, worker->path[depth], node, 
+                &worker->undo[played++]);
+        worker->path[++depth] = node;
+        worker->nodes++;
+#ifdef TEST
+        check_key(worker, node);
+#endif
+    }
+
+    if(node->numChildren < 0 && depth < MAX_DEPTH &&
+            expand_node(worker, node) == OK) { // expansion
+        node = &node->children[rng_range(&worker->rng, node->numChildren)];
+        play_node(worker, worker->path[depth], node, 
+                &worker->undo[played++]);
+        worker->path[++depth] = node;
+        worker->nodes++;
+#ifdef TEST
+        check_key(worker, node);
+#endif
+    }
+
+    Move moves[MAX_MOVES];
+    int mover = node->mover;
+    for(int i = 0; i < ROLLOUT_ROUNDS * pCount; i++) { // rollout
+        mover = (mover + 1) % pCount;
+        int count = player_moves(&worker->game, &worker->opponents[mover],
+                moves);
+        apply_move(&worker->game, &worker->opponents[mover],
+                &moves[rollout_choice(worker, moves, count)], 
+                &worker->undo[played++]);
+        worker->nodes++;
+    }
+
+    score_position(worker);
+    while(played) { // back to the root position
+        undo_move(&worker->game, &worker->undo[--played]);
+    }
+#ifdef TEST
+    check_restored(worker);
+#endif
+    for(int i = depth; i > -1; i--) { // backpropagation
+        double reward = worker->rewards[worker->path[i]->mover];
+        worker->path[i]->visits++;
+        worker->path[i]->score += reward;
+        if(i) {
+            trans_add(&search.table, &worker->counts, worker->path[i]->key, 
+                    reward);
+        }
+    }
+}
+
+/*
+ * searches from the root until the deadline
+ * params:  arg - worker to search with
+ * returns: NULL
+ */
+void* search_thread(void* arg) {
+    Worker* worker = (Worker*)arg;
+    restore_position(worker);
+    int pCount = worker->game.pCount;
+    worker->root->key = zobrist_position(&worker->game, worker->opponents, 
+            pCount) + mover_key(worker->root->mover, pCount);
+    while(time_usec() < worker->deadline) {
+        search_iteration(worker);
+    }
+
+    return NULL;
+}
+
+/*
+ * allocates the search threads scratch memory for this game
+ * params:  game - struct containing game relevant information
+ */
+void init_search(Game* game) {
+    trans_init(&search.table, env_number("SCAR_TABLE", TRANS_MEGABYTES));
+    search.workers = (Worker*)calloc(search.numThreads, sizeof(Worker));
+    for(int i = 0; i < search.numThreads; i++) {
+        Worker* worker = &search.workers[i];
+        worker->id = i;
+        worker->game = *game;
+        worker->game.stack.deck = (Deck)malloc(sizeof(Card) * BOARD_SIZE);
+        worker->cards = (int*)malloc(sizeof(int) * CARD_SIZE * BOARD_SIZE);
+        worker->opponents = (Opponent*)malloc(sizeof(Opponent) *
+                game->pCount);
+        worker->rewards = (double*)malloc(sizeof(double) * game->pCount);
+        worker->undo = (Undo*)malloc(sizeof(Undo) * (MAX_DEPTH + 
+                ROLLOUT_ROUNDS * game->pCount));
+        arena_init(&worker->arena, NODE_BLOCK);
+    }
+}
+
+/*
+ * frees the memory used by the search threads
+ */
+void shred_search(void) {
+    for(int i = 0; search.workers && i < search.numThreads; i++) {
+        free(search.workers[i].game.stack.deck);
+        free(search.workers[i].cards);
+        free(search.workers[i].opponents);
+        free(search.workers[i].rewards);
+        free(search.workers[i].undo);
+        arena_destroy(&search.workers[i].arena);
+    }
+    free(search.workers);
+    trans_destroy(&search.table);
+}
+
+/*
+ * converts the chosen move into a message for the hub
+ * params:  arena - arena to allocate the message from
+ *          move - move to send
+ * returns: msg containing the move
+ */
+Msg* move_to_msg(Arena* arena, Move* move) {
+    Msg* msg = (Msg*)arena_alloc(arena, sizeof(Msg));
+    msg->type = move->type;
+    if(move->type == PURCHASE || move->type == TAKE) {
+        msg->info = (Card)arena_alloc(arena, sizeof(int) * CARD_SIZE);
+        memset(msg->info, 0, sizeof(int) * CARD_SIZE);
+        memcpy(msg->info + 2, move->tokens, sizeof(int) * TOKEN_SIZE);
+        msg->card = move->card;
+        msg->wild = move->wild;
+    }
+
+    return msg;
+}
+
+/*
+ * works out how long to search for, all the hub allows for the move
+ * and no more than a share of what is left of the game, 
+ * SCAR_BUDGET if the hub keeps no budget
+ * params:  budget - milliseconds the hub allows
+ * returns: milliseconds to search for, reply included
+ */
+int think_time(Budget* budget) {
+    if(!budget->move && !budget->game) {
+        return search.budget;
+    }
+
+    int time = budget->move ? budget->move : INT_MAX;
+    if(budget->game && budget->game / GAME_SHARE < time) {
+        time = budget->game / GAME_SHARE;
+    }
+    return time > REPLY_MARGIN ? time : REPLY_MARGIN + 1;
+}
+
+/*
+ * scar_move searches for the next move with root-parallel monte carlo
+ * tree search, each thread builds its own tree until the budget runs out
+ * and the root visits are summed to choose the move
+ * params:  game - struct containing game relevant information,
+ *          followed by the opponents and the budget of the move
+ * returns: msg containing move for this player
+ */
+Msg* scar_move(Game* game, ...) {
+    va_list args;
+    va_start(args, game);
+    Opponent* opponents = va_arg(args, Opponent * );
+    Budget* budget = va_arg(args, Budget * );
+    va_end(args);
+
+    long long start = time_usec();
+    long long deadline = start +
+            (long long)(think_time(budget) - REPLY_MARGIN) * 1000;
+    if(!search.workers) {
+        init_search(game);
+    }
+
+    for(int i = 0; i < search.numThreads; i++) {
+        Worker* worker = &search.workers[i];
+        arena_reset(&worker->arena);
+        rng_seed(&worker->rng, search.seed ^
+                ((unsigned long long)search.moves << 16) ^ (i + 1));
+        worker->rootGame = game;
+        worker->rootOpponents = opponents;
+        worker->deadline = deadline;
+        worker->nodes = 0;
+        worker->root = (Node*)arena_alloc(&worker->arena, sizeof(Node));
+        memset(worker->root, 0, sizeof(Node));
+        worker->root->mover = (game->pID + game->pCount - 1) % game->pCount;
+        worker->root->numChildren = -1;
+        if(i && pthread_create(&worker->thread, NULL,
+                &search_thread, worker)) {
+            worker->deadline = 0; // no thread, search on the others
+        }
+    }
+    search_thread(&search.workers[0]);
+
+    long nodes = search.workers[0].nodes;
+    for(int i = 1; i < search.numThreads; i++) {
+        if(search.workers[i].deadline) {
+            pthread_join(search.workers[i].thread, NULL);
+            nodes += search.workers[i].nodes;
+        }
+    }
+    search.moves++;
+
+    Move moves[MAX_MOVES];
+    int count = player_moves(game, &opponents[game->pID], moves);
+    int chosen = 0;
+    int mostVisits = 0;
+    for(int i = 0; i < count; i++) {
+        int visits = 0;
+        for(int j = 0; j < search.numThreads; j++) {
+            Node* root = search.workers[j].root;
+            if(root->numChildren == count) {
+                visits += root->children[i].visits;
+            }
+        }
+
+        if(visits > mostVisits) {
+            mostVisits = visits;
+            chosen = i;
+        }
+    }
+
+    long long elapsed = time_usec() - start;
+    fprintf(stderr, "Searched %ld nodes in %lldms (%lld nodes/s)\n", nodes,
+            elapsed / 1000, elapsed ? nodes * 1000000LL / elapsed : 0);
+    TransCounts counts[search.numThreads];
+    for(int i = 0; i < search.numThreads; i++) {
+        counts[i] = search.workers[i].counts;
+    }
+    trans_report(&search.table, counts, search.numThreads, stderr);
+
+#ifdef TEST
+    fprintf(stderr, "scar[%d] chose move %d of %d with %d visits\n",
+            game->pID, chosen, count, mostVisits);
+#endif
+
+    return move_to_msg(game->arena, &moves[chosen]);
+}
+
+int main(int argc, char** argv) {
+    if(argc != 3) {
+        perr_msg(E_ARGC, SCAR);
+        return E_ARGC;
+    }
+
+    int pCount = check_pcount(argv[1]);
+    if (pCount == ERR) {
+        perr_msg(E_PCOUNT, SCAR);
+        return E_PCOUNT;
+    }
+
+    int pID = check_pid(argv[2], pCount);
+    if(pID == ERR) {
+        perr_msg(E_PID, SCAR);
+        return E_PID;
+    }
+
+    search.budget = env_number("SCAR_BUDGET", DEFAULT_BUDGET);
+    if(search.budget <= REPLY_MARGIN) {
+        search.budget = REPLY_MARGIN + 1;
+    }
+    search.numThreads = env_number("SCAR_THREADS", DEFAULT_THREADS);
+    if(search.numThreads < 1 || search.numThreads > MAX_THREADS) {
+        search.numThreads = DEFAULT_THREADS;
+    }
+    search.seed = (unsigned long long)env_number("SCAR_SEED", pID);
+
+    Game game;
+    init_player_game(pID, pCount, &game);
+
+    int signalList[] = {SIGPIPE};
+    init_signal_handler(signalList, 1);
+
+    Error err = play_game(&game, &scar_move, 0);
+    if(err == UTIL) {
+        err = OK;
+    }
+
+    if(err == ERR) {
+        err = E_COMMERR;
+    }
+
+    shred_player_game(&game);
+    shred_search();
+
+#ifdef TEST
+    fprintf(stderr, "scar exiting\n");
+#endif
+
+    perr_msg(err, SCAR);
+    return err;
+}
@@ -0,0 +1,389 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "err.h"
+#include "common.h"
+#include "hub.h"
+#include "signalHandler.h"
+#include "server.h"
+#include "trace.h"
+#include "metrics.h"
+#include "result.h"
+
+/*
+ * splits a job line into hub arguments in place, argv[0] is left empty
+ * so the arguments line up with those given to the hub
+ * params:  line - job line to split
+ *          argv - where to save the arguments, NULL terminated
+ * returns: number of arguments including argv[0]
+ */
+int split_job(char* line, char*** argv) {
+    int argc = 1;
+    int size = 8;
+    *argv = (char**)malloc(sizeof(char*) * size);
+    (*argv)[0] = "";
+    for(char* word = strtok(line, " \t\n"); word; 
+            word = strtok(NULL, " \t\n")) {
+        if(argc + 1 >= size) {
+            size *= 2;
+            *argv = (char**)realloc(*argv, sizeof(char*) * size);
+        }
+        (*argv)[argc++] = word;
+    }
+    (*argv)[argc] = NULL;
+
+    return argc;
+}
+
+/*
+ * frees a table so it can host the next job
+ * params:  table - table to clear
+ */
+void clear_table(Table* table) {
+    clear_game(&table->game, &table->session);
+    free(table->argv);
+    free(table->job);
+    table->job = NULL;
+    table->argv = NULL;
+}
+
+/*
+ * sets a table up for a job, starts its players and deals the game,
+ * players that fail to exec are only noticed once they do not reply
+ * params:  table - empty table to use
+ *          line - job line, tokens points deck player player [player ...]
+ *          options - hub options
+ *          seats - number of players already seated, for the fd limit
+ * returns: E_ARGC, E_ARGV, E_DECKIO or E_DECKR for a bad job,
+ *          E_EXEC if the players could not be started,
+ *          E_DEADPLAYER if a player disconnects while dealing,
+ *          OK otherwise
+ */
+Error open_table(Table* table, char* line, Options* options, int seats) {
+    memset(table, 0, sizeof(Table));
+    table->job = strdup(line);
+    int argc = split_job(table->job, &table->argv);
+    arena_init(&table->arena, TURN_BLOCK);
+    table->game.arena = &table->arena;
+    table->session.options = options;
+    if(argc < 6 || argc - 4 > MAX_PLAYERS) {
+        clear_table(table);
+        return E_ARGC;
+    }
+
+    Error err = hub_init(table->argv, &table->game);
+    if(err) {
+        clear_table(table);
+        return err;
+    }
+
+    raise_fd_limit(seats + argc - 4);
+    err = spawn_players(argc - 4, table->argv + 4, &table->game, 
+            &table->session);
+    if(err) {
+        release_players(table->game.pCount, table->session.players, err);
+        clear_table(table);
+        return err;
+    }
+    open_players(table->game.pCount, &table->session);
+
+    return begin_game(&table->game, &table->session);
+}
+
+/*
+ * ends the game at a table and lets its players go, 
+ * the table stays closing until they have all been reaped
+ * params:  table - table to close
+ *          err - what ended the game, UTIL if it was won
+ */
+void close_table(Table* table, Error err) {
+    table->result = finish_game(&table->game, &table->session, err);
+    release_players(table->game.pCount, table->session.players, 
+            table->result);
+    table->closing = 1;
+    table->deadline = metrics_now() + REAP_GRACE * 1000000ULL;
+}
+
+/*
+ * writes the result of a closing table once all its players are reaped,
+ * players still running past the deadline are killed
+ * params:  table - closing table
+ * returns: 1 if the table has been cleared,
+ *          0 if players are still running
+ */
+int settle_table(Table* table) {
+    Player* players = table->session.players;
+    int left = 0;
+    for(int i = 0; i < table->game.pCount; i++) {
+        left += players[i].pid > 0;
+    }
+    if(!left) {
+        write_result(&table->game, &table->session, table->result);
+        clear_table(table);
+        return 1;
+    }
+
+    if(metrics_now() > table->deadline) {
+        for(int i = 0; i < table->game.pCount; i++) {
+            if(players[i].pid > 0) {
+                kill(players[i].pid, SIGKILL);
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * saves the resource usage of a reaped player in the record of its seat
+ * params:  tables - tables of the server
+ *          numTables - number of tables
+ *          pid - process that was reaped
+ *          usage - what the process cost
+ */
+void reaped(Table* tables, int numTables, pid_t pid, struct rusage* usage) {
+    for(int i = 0; i < numTables; i++) {
+        if(!tables[i].job) {
+            continue;
+        }
+        Session* session = &tables[i].session;
+        for(int j = 0; j < tables[i].game.pCount; j++) {
+            if(session->players[j].pid == pid) {
+                session->players[j].pid = 0;
+                session->records[j].usage = *usage;
+                session->records[j].measured = 1;
+                return;
+            }
+        }
+    }
+}
+
+/*
+ * plays the game at a table until it waits on a reply not yet read
+ * params:  table - table to play
+ * returns: OK while the game goes on,
+ *          what ended the game otherwise, UTIL if it was won
+ */
+Error play_table(Table* table) {
+    Game* game = &table->game;
+    Session* session = &table->session;
+    Error err = OK;
+    while(!err) {
+        Player* player = &session->players[session->turn];
+        if(player->plugin) {
+            err = take_move(game, session, NULL);
+        } else if(reader_has_line(&player->fromChild)) {
+            char* line = reader_line(&player->fromChild, 0, 0);
+            err = line ? take_move(game, session, line) : E_PROTOCOL;
+        } else {
+            return OK;
+        }
+    }
+
+    return err;
+}
+
+/*
+ * works out how long the server may wait on its players, 
+ * no longer than the earliest deadline of a polled table
+ * params:  tables - tables of the server
+ *          polled - index of the table of every polled player
+ *          count - number of polled players
+ *          closing - 1 if a table waits on its players to be reaped
+ * returns: milliseconds to poll for, -1 to wait for a reply
+ */
+int poll_timeout(Table* tables, int* polled, int count, int closing) {
+    int timeout = closing ? REAP_POLL : -1;
+    uint64_t now = metrics_now();
+    for(int i = 0; i < count; i++) {
+        uint64_t deadline = tables[polled[i]].session.deadline;
+        if(!deadline) {
+            continue;
+        }
+        int wait = deadline > now ? 
+                (int)((deadline - now + 999999) / 1000000) : 0;
+        timeout = timeout < 0 || wait < timeout ? wait : timeout;
+    }
+
+    return timeout;
+}
+
+/*
+ * reads jobs until one gets a game going on the table, 
+ * the game may have ended already, leaving the table closing
+ * params:  table - empty table to use
+ *          jobs - jobs file
+ *          options - hub options
+ *          number - line number of the last job read
+ *          seats - number of players already seated
+ * returns: 1 if the table is in use,
+ *          0 if the jobs have run out
+ */
+int fill_table(Table* table, FILE* jobs, Options* options, int* number,
+        int seats) {
+    char* line = NULL;
+    size_t size = 0;
+    while(getline(&line, &size, jobs) > 0) {
+        (*number)++;
+        char* first = line + strspn(line, " \t\n");
+        if(*first == '\0' || *first == '#') {
+            continue;
+        }
+
+        Error err = open_table(table, line, options, seats);
+        if(table->job) {
+            table->number = *number;
+            table->session.job = *number; // tags the result record
+            if(!err) {
+                err = play_table(table); // plugins may move straight away
+            }
+            if(err) {
+                close_table(table, err);
+            }
+            free(line);
+            return 1;
+        }
+        fprintf(stderr, "Job %d: ", *number);
+        if(err == E_ARGC) { // not the hub's usage, which is for its own args
+            fprintf(stderr, "bad job line\n");
+        } else {
+            herr_msg(err);
+        }
+    }
+    free(line);
+
+    return 0;
+}
+
+/*
+ * plays every game in the jobs file, up to options->tables at once, 
+ * in a single loop polling the player whose turn it is at each table;
+ * an error only ends the game it happened in
+ * params:  options - hub options, jobFile and tables are used
+ * returns: E_ARGV if the jobs file cannot be read,
+ *          E_SIGINT if sigint was caught,
+ *          OK otherwise
+ */
+Error run_server(Options* options) {
+    FILE* jobs = fopen(options->jobFile, "r");
+    if(!jobs) {
+        return E_ARGV;
+    }
+    if(!options->resultFile) {
+        options->resultFile = SERVER_RESULTS;
+    }
+
+    // a dead player shows up on its own pipe, not through a signal
+    int signalList[] = {SIGINT};
+    init_signal_handler(signalList, 1);
+    signal(SIGPIPE, SIG_IGN);
+
+    Table* tables = (Table*)calloc(options->tables, sizeof(Table));
+    struct pollfd* fds = (struct pollfd*)malloc(sizeof(struct pollfd) * 
+            options->tables);
+    int* polled = (int*)malloc(sizeof(int) * options->tables);
+    int number = 0;
+    int more = 1;
+    int open = 0;
+    int seats = 0;
+    Error err = OK;
+    while((more || open) && !(err = check_signal())) {
+        for(int i = 0; more && i < options->tables; i++) {
+            if(!tables[i].job) {
+                more = fill_table(&tables[i], jobs, options, &number, seats);
+                open += more;
+                seats += more ? tables[i].game.pCount : 0;
+            }
+        }
+
+        int count = 0;
+        int closing = 0;
+        for(int i = 0; i < options->tables; i++) {
+            if(tables[i].job && !tables[i].closing) {
+                Session* session = &tables[i].session;
+                fds[count].fd = session->players[session->turn].fromChild.fd;
+                fds[count].events = POLLIN;
+                polled[count++] = i;
+            }
+            closing += tables[i].job && tables[i].closing;
+        }
+        int timeout = poll_timeout(tables, polled, count, closing);
+        if((count || closing) && poll(fds, count, timeout) >= 0) {
+            uint64_t now = metrics_now();
+            for(int i = 0; i < count; i++) {
+                Table* table = &tables[polled[i]];
+                Session* session = &table->session;
+                if(!fds[i].revents) {
+                    if(session->deadline && now > session->deadline) {
+                        METRIC_ADD(timeouts, 1);
+                        close_table(table, E_TIMEOUT);
+                    }
+                    continue;
+                }
+                Error result = E_DEADPLAYER;
+                uint64_t start = trace_begin();
+                Reader* reader = &session->players[session->turn].fromChild;
+                int got = reader_fill(reader);
+                trace_end("read_line", start);
+                if(got > 0) {
+                    result = play_table(table);
+                }
+                if(result) {
+                    close_table(table, result);
+                }
+            }
+        }
+
+        pid_t pid;
+        struct rusage usage;
+        while((pid = wait4(-1, NULL, WNOHANG, &usage)) > 0) {
+            reaped(tables, options->tables, pid, &usage);
+        }
+        for(int i = 0; i < options->tables; i++) {
+            int pCount = tables[i].game.pCount;
+            if(tables[i].job && tables[i].closing && 
+                    settle_table(&tables[i])) {
+                open--;
+                seats -= pCount;
+            }
+        }
+    }
+
+    for(int i = 0; i < options->tables; i++) { // interrupted
+        if(tables[i].job && !tables[i].closing) {
+            close_table(&tables[i], err);
+        }
+    }
+    while(open) {
+        pid_t pid;
+        struct rusage usage;
+        if((pid = wait4(-1, NULL, 0, &usage)) > 0) {
+            reaped(tables, options->tables, pid, &usage);
+        } else if(errno == ECHILD) { // nothing left to reap
+            for(int i = 0; i < options->tables; i++) {
+                for(int j = 0; tables[i].job && 
+                        j < tables[i].game.pCount; j++) {
+                    tables[i].session.players[j].pid = 0;
+                }
+            }
+        }
+        for(int i = 0; i < options->tables; i++) {
+            if(tables[i].job && settle_table(&tables[i])) {
+                open--;
+            }
+        }
+    }
+    free(polled);
+    free(fds);
+    free(tables);
+    fclose(jobs);
+
+    return err;
+}
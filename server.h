@@ -0,0 +1,31 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "err.h"
+#include "common.h"
+#include "arena.h"
+#include "options.h"
+#include "process.h"
+
+// where result records go when serving without a result file
+#define SERVER_RESULTS "/dev/stdout"
+
+// a game hosted by the server, the arguments point into the job line,
+// only the reply of the player whose turn it is is ever awaited;
+// a closing table has ended with result and waits until deadline for its
+// players to be reaped before the result record is written
+typedef struct {
+    Game game;
+    Session session;
+    Arena arena;
+    char* job;
+    char** argv;
+    int number;
+    int closing;
+    Error result;
+    uint64_t deadline;
+} Table;
+
+Error run_server(Options* options);
+
+#endif
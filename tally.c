@@ -0,0 +1,556 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "err.h"
+#include "common.h"
+#include "result.h"
+
+// tag of lines holding partial aggregates
+#define TALLY_TAG "tally"
+// longest input line, a record with MAX_PLAYERS seats fits comfortably
+#define TALLY_LINE 65536
+// maximum number of distinct strategies tracked
+#define MAX_STRATEGIES 64
+// number of ways a game can end, see result_status
+#define NUM_STATUS 7
+// z score of the 95% confidence interval
+#define Z95 1.959964
+
+// running count, mean and sum of squared deviations of a value,
+// updated one sample at a time and merged in constant time
+typedef struct {
+    long long n;
+    double mean;
+    double m2;
+} Moments;
+
+// statistics of one player program over every finished game it played,
+// cpu in milliseconds, rss in kilobytes and switches are per game and 
+// only count games where the program had a process of its own
+typedef struct {
+    char name[LINE_BUFF * 4];
+    long long games;
+    long long wins;
+    Moments points;
+    Moments wilds;
+    Moments cards;
+    Moments cpu;
+    Moments rss;
+    Moments switches;
+} Strategy;
+
+// everything known about the games read so far,
+// memory depends on the number of strategies, never the number of games
+typedef struct {
+    long long status[NUM_STATUS];
+    Moments rounds;
+    long long seatGames[MAX_PLAYERS];
+    long long seatWins[MAX_PLAYERS];
+    int numStrategies;
+    Strategy strategies[MAX_STRATEGIES];
+} Tally;
+
+// one seat of a game record, read in full before anything is counted,
+// cpu, rss and switches are only set if the seat was measured
+typedef struct {
+    char* name;
+    int values[4]; // points, wilds, cards, won
+    int measured;
+    double cpu;
+    long long rss;
+    long long switches;
+} Seat;
+
+char* statusNames[NUM_STATUS] = {"finished", "protocol", "disconnected",
+        "interrupted", "aborted", "timeout", "error"};
+
+/*
+ * adds a sample to the moments
+ * params:  moments - moments to update
+ *          value - sample to add
+ */
+void moments_add(Moments* moments, double value) {
+    moments->n++;
+    double delta = value - moments->mean;
+    moments->mean += delta / moments->n;
+    moments->m2 += delta * (value - moments->mean);
+}
+
+/*
+ * merges the moments of two disjoint sets of samples
+ * params:  into - moments to merge into
+ *          from - moments to merge
+ */
+void moments_merge(Moments* into, Moments* from) {
+    if(!from->n) {
+        return;
+    }
+    long long n = into->n + from->n;
+    double delta = from->mean - into->mean;
+    into->mean += delta * from->n / n;
+    into->m2 += from->m2 + delta * delta * into->n * from->n / n;
+    into->n = n;
+}
+
+/*
+ * sample standard deviation of the moments
+ * params:  moments - moments to read
+ * returns: standard deviation, 0 with fewer than 2 samples
+ */
+double moments_sd(Moments* moments) {
+    return moments->n > 1 ? sqrt(moments->m2 / (moments->n - 1)) : 0;
+}
+
+/*
+ * wilson score interval of a proportion at 95% confidence
+ * params:  wins - number of successes
+ *          games - number of trials
+ *          low - where to save the lower bound
+ *          high - where to save the upper bound
+ */
+void wilson(long long wins, long long games, double* low, double* high) {
+    if(!games) {
+        *low = 0;
+        *high = 1;
+        return;
+    }
+    double p = (double)wins / games;
+    double z2 = Z95 * Z95;
+    double centre = (p + z2 / (2 * games)) / (1 + z2 / games);
+    double spread = Z95 * sqrt(p * (1 - p) / games +
+            z2 / (4.0 * games * games)) / (1 + z2 / games);
+    *low = centre - spread;
+    *high = centre + spread;
+}
+
+/*
+ * finds a strategy by name, adding it if it is new
+ * params:  tally - aggregate to search
+ *          name - program name of the strategy
+ * returns: NULL if there are too many strategies,
+ *          the strategy otherwise
+ */
+Strategy* find_strategy(Tally* tally, char* name) {
+    for(int i = 0; i < tally->numStrategies; i++) {
+        if(!strcmp(tally->strategies[i].name, name)) {
+            return &tally->strategies[i];
+        }
+    }
+    if(tally->numStrategies == MAX_STRATEGIES ||
+            strlen(name) >= sizeof(tally->strategies[0].name)) {
+        return NULL;
+    }
+    Strategy* strategy = &tally->strategies[tally->numStrategies++];
+    memset(strategy, 0, sizeof(Strategy));
+    strcpy(strategy->name, name);
+    return strategy;
+}
+
+/*
+ * finds the index of a status name
+ * params:  name - name of the status
+ * returns: ERR if unknown,
+ *          index of the status otherwise
+ */
+int find_status(char* name) {
+    for(int i = 0; i < NUM_STATUS; i++) {
+        if(!strcmp(statusNames[i], name)) {
+            return i;
+        }
+    }
+    return ERR;
+}
+
+/*
+ * reads one seat of a game record, the name is left in the field
+ * params:  field - seat field of the record, modified
+ *          seat - where to save the seat
+ * returns: ERR if the seat is invalid,
+ *          OK otherwise
+ */
+Error read_seat(char* field, Seat* seat) {
+    for(int i = 3; i >= 0; i--) { // program names may contain ':'
+        char* colon = strrchr(field, ':');
+        if(!colon || !is_all_num(colon + 1) || !colon[1]) {
+            return ERR;
+        }
+        seat->values[i] = atoi(colon + 1);
+        *colon = '\0';
+    }
+    seat->name = field;
+    seat->measured = 0;
+    return OK;
+}
+
+/*
+ * reads the cost fields that follow the seats of a game record, 
+ * records written before costs were kept have none
+ * params:  seats - seats of the record to save the costs in
+ *          count - number of seats
+ *          save - strtok_r state of the record
+ * returns: ERR if the costs are invalid,
+ *          OK otherwise
+ */
+Error read_costs(Seat* seats, int count, char** save) {
+    for(int i = 0; i < count; i++) {
+        char* field = strtok_r(NULL, " \n", save);
+        if(!field) {
+            return i ? ERR : OK;
+        }
+        if(!strcmp(field, "-")) { // no process of its own
+            continue;
+        }
+        long long user, system, rss, voluntary, involuntary;
+        char end;
+        if(sscanf(field, "%lld:%lld:%lld:%lld:%lld%c", &user, &system, 
+                &rss, &voluntary, &involuntary, &end) != 5) {
+            return ERR;
+        }
+        seats[i].measured = 1;
+        seats[i].cpu = (user + system) / 1000.0;
+        seats[i].rss = rss;
+        seats[i].switches = voluntary + involuntary;
+    }
+
+    return OK;
+}
+
+/*
+ * adds a finished game's seat to its strategy and the seat statistics
+ * params:  tally - aggregate to add to
+ *          strategy - strategy that played the seat
+ *          seat - seat read from the record
+ *          index - place of the seat in the game
+ */
+void add_seat(Tally* tally, Strategy* strategy, Seat* seat, int index) {
+    strategy->games++;
+    strategy->wins += seat->values[3];
+    moments_add(&strategy->points, seat->values[0]);
+    moments_add(&strategy->wilds, seat->values[1]);
+    moments_add(&strategy->cards, seat->values[2]);
+    if(seat->measured) {
+        moments_add(&strategy->cpu, seat->cpu);
+        moments_add(&strategy->rss, seat->rss);
+        moments_add(&strategy->switches, seat->switches);
+    }
+    tally->seatGames[index]++;
+    tally->seatWins[index] += seat->values[3];
+}
+
+/*
+ * adds a game record to the aggregate, the whole record is read before
+ * anything is counted so an invalid record leaves the aggregate as it was,
+ * only finished games count towards the strategy and seat statistics
+ * params:  tally - aggregate to add to
+ *          line - record without the tag
+ * returns: ERR if the record is invalid,
+ *          OK otherwise
+ */
+Error add_game(Tally* tally, char* line) {
+    char* save;
+    char* field = strtok_r(line, " \n", &save);
+    int status = field ? find_status(field) : ERR;
+    char* rounds = strtok_r(NULL, " \n", &save);
+    char* count = strtok_r(NULL, " \n", &save);
+    if(status == ERR || !rounds || !count || !is_all_num(rounds) ||
+            !is_all_num(count) || atoi(count) > MAX_PLAYERS) {
+        return ERR;
+    }
+
+    int numSeats = atoi(count);
+    Seat seats[MAX_PLAYERS];
+    for(int i = 0; i < numSeats; i++) {
+        if(!(field = strtok_r(NULL, " \n", &save)) || 
+                read_seat(field, &seats[i]) != OK) {
+            return ERR;
+        }
+    }
+    if(read_costs(seats, numSeats, &save) != OK) {
+        return ERR;
+    }
+
+    Strategy* seated[MAX_PLAYERS];
+    int known = tally->numStrategies;
+    for(int i = 0; !status && i < numSeats; i++) {
+        if(!(seated[i] = find_strategy(tally, seats[i].name))) {
+            tally->numStrategies = known; // drop strategies it added
+            return ERR;
+        }
+    }
+
+    tally->status[status]++;
+    if(status) {
+        return OK;
+    }
+    moments_add(&tally->rounds, atoi(rounds));
+    for(int i = 0; i < numSeats; i++) {
+        add_seat(tally, seated[i], &seats[i], i);
+    }
+
+    return OK;
+}
+
+/*
+ * reads moments written by dump_moments
+ * params:  save - strtok_r state of the line
+ *          moments - where to save the moments
+ * returns: ERR if fields are missing,
+ *          OK otherwise
+ */
+Error read_moments(char** save, Moments* moments) {
+    char* n = strtok_r(NULL, " \n", save);
+    char* mean = strtok_r(NULL, " \n", save);
+    char* m2 = strtok_r(NULL, " \n", save);
+    if(!n || !mean || !m2) {
+        return ERR;
+    }
+    moments->n = atoll(n);
+    moments->mean = strtod(mean, NULL);
+    moments->m2 = strtod(m2, NULL);
+    return OK;
+}
+
+/*
+ * merges a partial aggregate line written by dump_tally
+ * params:  tally - aggregate to merge into
+ *          line - partial aggregate without the tag
+ * returns: ERR if the line is invalid,
+ *          OK otherwise
+ */
+Error merge_line(Tally* tally, char* line) {
+    char* save;
+    char* kind = strtok_r(line, " \n", &save);
+    char* name = strtok_r(NULL, " \n", &save);
+    if(!kind || !name) {
+        return ERR;
+    }
+
+    if(!strcmp(kind, "status")) {
+        char* count = strtok_r(NULL, " \n", &save);
+        if(find_status(name) == ERR || !count) {
+            return ERR;
+        }
+        tally->status[find_status(name)] += atoll(count);
+        return OK;
+    }
+
+    if(!strcmp(kind, "rounds")) {
+        Moments rounds = {atoll(name), 0, 0};
+        char* mean = strtok_r(NULL, " \n", &save);
+        char* m2 = strtok_r(NULL, " \n", &save);
+        if(!mean || !m2) {
+            return ERR;
+        }
+        rounds.mean = strtod(mean, NULL);
+        rounds.m2 = strtod(m2, NULL);
+        moments_merge(&tally->rounds, &rounds);
+        return OK;
+    }
+
+    if(!strcmp(kind, "seat")) {
+        char* games = strtok_r(NULL, " \n", &save);
+        char* wins = strtok_r(NULL, " \n", &save);
+        int seat = atoi(name);
+        if(!games || !wins || seat < 0 || seat >= MAX_PLAYERS) {
+            return ERR;
+        }
+        tally->seatGames[seat] += atoll(games);
+        tally->seatWins[seat] += atoll(wins);
+        return OK;
+    }
+
+    if(!strcmp(kind, "strategy")) {
+        Strategy from;
+        memset(&from, 0, sizeof(Strategy));
+        char* games = strtok_r(NULL, " \n", &save);
+        char* wins = strtok_r(NULL, " \n", &save);
+        if(!games || !wins ||
+                read_moments(&save, &from.points) != OK ||
+                read_moments(&save, &from.wilds) != OK ||
+                read_moments(&save, &from.cards) != OK) {
+            return ERR;
+        }
+        if(read_moments(&save, &from.cpu) == OK && // older totals lack costs
+                (read_moments(&save, &from.rss) != OK ||
+                read_moments(&save, &from.switches) != OK)) {
+            return ERR;
+        }
+        Strategy* strategy = find_strategy(tally, name); // once it is valid
+        if(!strategy) {
+            return ERR;
+        }
+        strategy->games += atoll(games);
+        strategy->wins += atoll(wins);
+        moments_merge(&strategy->points, &from.points);
+        moments_merge(&strategy->wilds, &from.wilds);
+        moments_merge(&strategy->cards, &from.cards);
+        moments_merge(&strategy->cpu, &from.cpu);
+        moments_merge(&strategy->rss, &from.rss);
+        moments_merge(&strategy->switches, &from.switches);
+        return OK;
+    }
+
+    return ERR;
+}
+
+/*
+ * reads game records and partial aggregates into the aggregate,
+ * invalid lines are reported and skipped
+ * params:  tally - aggregate to add to
+ *          input - stream to read
+ *          name - name of the stream for error messages
+ */
+void read_input(Tally* tally, FILE* input, char* name) {
+    char line[TALLY_LINE];
+    long long lineNum = 0;
+    while(fgets(line, TALLY_LINE, input)) {
+        lineNum++;
+        Error err = ERR;
+        if(!strncmp(line, RESULT_TAG " ", strlen(RESULT_TAG " "))) {
+            err = add_game(tally, line + strlen(RESULT_TAG " "));
+        } else if(!strncmp(line, TALLY_TAG " ", strlen(TALLY_TAG " "))) {
+            err = merge_line(tally, line + strlen(TALLY_TAG " "));
+        }
+        if(err) {
+            fprintf(stderr, "%s:%lld: skipped invalid line\n",
+                    name, lineNum);
+        }
+    }
+}
+
+/*
+ * prints moments for read_moments
+ * params:  moments - moments to print
+ */
+void dump_moments(Moments* moments) {
+    printf(" %lld %.17g %.17g", moments->n, moments->mean, moments->m2);
+}
+
+/*
+ * prints the aggregate as partial aggregate lines,
+ * which can be read back and merged with others
+ * params:  tally - aggregate to print
+ */
+void dump_tally(Tally* tally) {
+    for(int i = 0; i < NUM_STATUS; i++) {
+        printf(TALLY_TAG " status %s %lld\n", statusNames[i],
+                tally->status[i]);
+    }
+    printf(TALLY_TAG " rounds %lld %.17g %.17g\n", tally->rounds.n,
+            tally->rounds.mean, tally->rounds.m2);
+    for(int i = 0; i < MAX_PLAYERS; i++) {
+        if(tally->seatGames[i]) {
+            printf(TALLY_TAG " seat %d %lld %lld\n", i,
+                    tally->seatGames[i], tally->seatWins[i]);
+        }
+    }
+    for(int i = 0; i < tally->numStrategies; i++) {
+        Strategy* strategy = &tally->strategies[i];
+        printf(TALLY_TAG " strategy %s %lld %lld", strategy->name,
+                strategy->games, strategy->wins);
+        dump_moments(&strategy->points);
+        dump_moments(&strategy->wilds);
+        dump_moments(&strategy->cards);
+        dump_moments(&strategy->cpu);
+        dump_moments(&strategy->rss);
+        dump_moments(&strategy->switches);
+        printf("\n");
+    }
+}
+
+/*
+ * prints the aggregate as a readable report,
+ * win rates come with 95% wilson intervals, means with standard deviations
+ * params:  tally - aggregate to print
+ */
+void print_tally(Tally* tally) {
+    printf("games:");
+    for(int i = 0; i < NUM_STATUS; i++) {
+        printf(" %s=%lld", statusNames[i], tally->status[i]);
+    }
+    printf("\nrounds: %.2f sd %.2f\n\n", tally->rounds.mean,
+            moments_sd(&tally->rounds));
+
+    printf("%-16s %10s %10s %7s %17s %15s %15s %15s\n", "strategy", "games",
+            "wins", "win%", "95% interval", "points", "wilds", "cards");
+    for(int i = 0; i < tally->numStrategies; i++) {
+        Strategy* strategy = &tally->strategies[i];
+        double low, high;
+        wilson(strategy->wins, strategy->games, &low, &high);
+        printf("%-16s %10lld %10lld %6.2f%% %7.2f%%-%7.2f%% "
+                "%7.2f sd %4.2f %7.2f sd %4.2f %7.2f sd %4.2f\n",
+                strategy->name, strategy->games, strategy->wins,
+                strategy->games ?
+                100.0 * strategy->wins / strategy->games : 0,
+                100 * low, 100 * high,
+                strategy->points.mean, moments_sd(&strategy->points),
+                strategy->wilds.mean, moments_sd(&strategy->wilds),
+                strategy->cards.mean, moments_sd(&strategy->cards));
+    }
+
+    printf("\n%-16s %10s %17s %17s %17s\n", "strategy", "measured", 
+            "cpu ms", "max rss KB", "switches");
+    for(int i = 0; i < tally->numStrategies; i++) {
+        Strategy* strategy = &tally->strategies[i];
+        if(!strategy->cpu.n) {
+            continue;
+        }
+        printf("%-16s %10lld %8.2f sd %5.2f %8.0f sd %5.0f %8.1f sd %5.1f\n",
+                strategy->name, strategy->cpu.n, 
+                strategy->cpu.mean, moments_sd(&strategy->cpu),
+                strategy->rss.mean, moments_sd(&strategy->rss),
+                strategy->switches.mean, moments_sd(&strategy->switches));
+    }
+
+    printf("\n%-16s %10s %10s %7s %17s\n", "seat", "games", "wins", "win%",
+            "95% interval");
+    for(int i = 0; i < MAX_PLAYERS; i++) {
+        if(!tally->seatGames[i]) {
+            continue;
+        }
+        double low, high;
+        wilson(tally->seatWins[i], tally->seatGames[i], &low, &high);
+        char name[ID_SIZE];
+        printf("%-16s %10lld %10lld %6.2f%% %7.2f%%-%7.2f%%\n",
+                player_name(i, name), tally->seatGames[i], tally->seatWins[i],
+                100.0 * tally->seatWins[i] / tally->seatGames[i],
+                100 * low, 100 * high);
+    }
+}
+
+/*
+ * reads result records written by austerity -r and partial aggregates
+ * from the given files, or stdin, and reports the combined statistics;
+ * with -s the combined aggregate is printed for merging instead
+ */
+int main(int argc, char** argv) {
+    static Tally tally;
+    int dump = 0;
+    int first = 1;
+    if(argc > 1 && !strcmp(argv[1], "-s")) {
+        dump = 1;
+        first++;
+    }
+
+    if(first == argc) {
+        read_input(&tally, stdin, "stdin");
+    }
+    for(int i = first; i < argc; i++) {
+        FILE* input = fopen(argv[i], "r");
+        if(!input) {
+            fprintf(stderr, "Cannot read %s\n", argv[i]);
+            return E_DECKIO;
+        }
+        read_input(&tally, input, argv[i]);
+        fclose(input);
+    }
+
+    if(dump) {
+        dump_tally(&tally);
+    } else {
+        print_tally(&tally);
+    }
+
+    return OK;
+}
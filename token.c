@@ -8,15 +8,17 @@
 #include "playerCommon.h"
 #include "token.h"
 #include "card.h"
+#include "moves.h"
 
 /* checks if tokens are valid
  * if valid, takes them in the given order
- * params:  tokens - array of available tokens
+ * params:  arena - arena to allocate the result from
+ *          tokens - array of available tokens
  *          tokenOrder - order in which to prefer tokens
  * returns: NULL if no tokens taken,
  *          otherwise, an array of which tokens were taken
  */
-int* get_tokens(int* tokens, int* tokenOrder) {
+int* get_tokens(Arena* arena, int* tokens, int* tokenOrder) {
 #ifdef VERBOSE 
     fprintf(stderr, "got token order:%d,%d,%d,%d\n", 
             tokenOrder[0], tokenOrder[1], tokenOrder[2], tokenOrder[3]);
@@ -34,9 +36,10 @@ int* get_tokens(int* tokens, int* tokenOrder) {
     }
 
     int tokenCount = 0;
-    int* currentTokens = (int*)malloc(TOKEN_SIZE * sizeof(int));
+    int currentTokens[TOKEN_SIZE];
     memcpy(currentTokens, tokens, TOKEN_SIZE * sizeof(int));
-    int* takenTokens = (int*)calloc(TOKEN_SIZE, sizeof(int));
+    int* takenTokens = (int*)arena_alloc(arena, TOKEN_SIZE * sizeof(int));
+    memset(takenTokens, 0, TOKEN_SIZE * sizeof(int));
     for(int i = 0; i < TOKEN_SIZE && tokenCount < 3; i++) {
         if(currentTokens[tokenOrder[i]] > 0) {
             currentTokens[tokenOrder[i]]--;
@@ -46,7 +49,6 @@ int* get_tokens(int* tokens, int* tokenOrder) {
             takenTokens[tokenOrder[i]] = 0;
         }
     }
-    free(currentTokens);
 
     return takenTokens;
     
@@ -61,7 +63,7 @@ int* get_tokens(int* tokens, int* tokenOrder) {
  * returns: E_COMMERR if invalid token number,
  *          OK otherwise
  */
-Error took_tokens(Game* game, Card card, Opponent* opponents, char player) {
+Error took_tokens(Game* game, Card card, Opponent* opponents, int player) {
     if(card[PURPLE] < 0 || card[PURPLE] > INT_MAX || 
             card[BROWN] < 0 || card[BROWN] > INT_MAX || 
             card[YELLOW] < 0 || card[YELLOW] > INT_MAX || 
@@ -71,8 +73,8 @@ Error took_tokens(Game* game, Card card, Opponent* opponents, char player) {
 
     for(int i = 0; i < TOKEN_SIZE; i++) {
         game->tokens[i] -= card[i + 2];
-        opponents[(int)(player - TOCHAR)].tokens[i] += card[i + 2]; 
-        if(player == game->pID + TOCHAR) {
+        opponents[player].tokens[i] += card[i + 2]; 
+        if(player == game->pID) {
             game->ownedTokens[i] += card[i + 2];
         }
     }
@@ -81,11 +83,13 @@ Error took_tokens(Game* game, Card card, Opponent* opponents, char player) {
     fprintf(stderr, "tokens set: %d,%d,%d,%d; ", 
             game->tokens[0], game->tokens[1],
             game->tokens[2], game->tokens[3]);
-    fprintf(stderr, "player %c set: %d,%d,%d,%d\n", player, 
-            opponents[(int)(player - TOCHAR)].tokens[0], 
-            opponents[(int)(player - TOCHAR)].tokens[1],
-            opponents[(int)(player - TOCHAR)].tokens[2], 
-            opponents[(int)(player - TOCHAR)].tokens[3]);
+    char name[ID_SIZE];
+    fprintf(stderr, "player %s set: %d,%d,%d,%d\n", 
+            player_name(player, name), 
+            opponents[player].tokens[0], 
+            opponents[player].tokens[1],
+            opponents[player].tokens[2], 
+            opponents[player].tokens[3]);
 #endif
     
     return OK;
@@ -102,7 +106,7 @@ Error took_tokens(Game* game, Card card, Opponent* opponents, char player) {
  *          OK otherwise
  */
 Error returned_tokens(Game* game, Card card, int wild, Opponent* opponents, 
-        char player) {
+        int player) {
     if(card[PURPLE] < 0 || card[PURPLE] > INT_MAX || 
             card[BROWN] < 0 || card[BROWN] > INT_MAX || 
             card[YELLOW] < 0 || card[YELLOW] > INT_MAX || 
@@ -112,13 +116,13 @@ Error returned_tokens(Game* game, Card card, int wild, Opponent* opponents,
 
     for(int i = 0; i < TOKEN_SIZE; i++) {
         game->tokens[i] += card[i + 2];
-        opponents[(int)(player - TOCHAR)].tokens[i] -= card[i + 2]; 
-        if(player == game->pID + TOCHAR) {
+        opponents[player].tokens[i] -= card[i + 2]; 
+        if(player == game->pID) {
             game->ownedTokens[i] -= card[i + 2];
         }
     }
     
-    if(player == game->pID + TOCHAR) {
+    if(player == game->pID) {
         game->wild -= wild;
     }
 
@@ -131,9 +135,9 @@ Error returned_tokens(Game* game, Card card, int wild, Opponent* opponents,
  *          opponents - array of structs containing player information
  *          player - player who took wild
  */
-void update_wild(Game* game, Opponent* opponents, char player) {
-    opponents[(int)(player - TOCHAR)].wild += 1;
-    if(player == game->pID + TOCHAR) {
+void update_wild(Game* game, Opponent* opponents, int player) {
+    opponents[player].wild += 1;
+    if(player == game->pID) {
         game->wild += 1;
     }
 }
@@ -173,53 +177,24 @@ Error set_tokens(Game* game, int numTokens) {
  *          number of wild tokens used otherwise
  */
 int can_afford(Card card, int* discount, int* tokens, int wild) {
-    int usedWild = 0;
-    for(int i = 0; i < TOKEN_SIZE; i++) {
-        int cost = card[i + 2] - discount[i];
-        if(cost > tokens[i] + wild - usedWild) {
-            return -1;
-        }
-        
-        if(cost > tokens[i]) {
-            usedWild += cost - tokens[i];
-        }
-    }
-        
-    return usedWild;
+    return card_payment(card, discount, tokens, wild, NULL);
 }
 
 /*
- * determines how many tokens are used in the purchase
- * params:  discount - array of discounts from owned cards
+ * determines how many tokens are used in the purchase, priced by 
+ * card_payment as the hub prices it
+ * params:  arena - arena to allocate the result from
+ *          discount - array of discounts from owned cards
  *          tokens - number of owned tokens
+ *          wild - number of owned wild tokens
  *          card - card to check with
  * returns: int array of tokens used
  */
-int* get_card_cost(int* discount, int* tokens, Card card) {
-    int* usedTokens = (int*)calloc(TOKEN_SIZE, sizeof(int));
-    for(int i = 0; i < TOKEN_SIZE; i++) {
-        int cost = card[i + 2] - discount[i];
-        if(cost < 1) { // no tokens required
-            usedTokens[i] = 0;
-        } else { // if tokens required
-            if(cost <= tokens[i]) {
-                usedTokens[i] = cost;
-            } else { // wild tokens required
-                usedTokens[i] = tokens[i];
-            }
-        }
-
-#ifdef VERBOSE 
-        fprintf(stderr, "cost:%d, discount:%d, have:%d, used:%d, wild:%d\n", 
-                card[i + 2] - discount[i], 
-                discount[i],
-                tokens[i],
-                usedTokens[i], 
-                (card[i + 2] - discount[i] < 0) ? 0 : 
-                card[i + 2] - discount[i] - tokens[i]);
-#endif
-    }
-
+int* get_card_cost(Arena* arena, int* discount, int* tokens, int wild, 
+        Card card) {
+    int* usedTokens = (int*)arena_alloc(arena, TOKEN_SIZE * sizeof(int));
+    memset(usedTokens, 0, TOKEN_SIZE * sizeof(int)); // if it is not afforded
+    card_payment(card, discount, tokens, wild, usedTokens);
     return usedTokens;
 }
 
@@ -6,20 +6,21 @@
 #include "card.h"
 #include "playerCommon.h"
 
-int* get_tokens(int* tokens, int* tokenOrder);
+int* get_tokens(Arena* arena, int* tokens, int* tokenOrder);
 
-Error took_tokens(Game* game, Card card, Opponent* opponents, char player);
+Error took_tokens(Game* game, Card card, Opponent* opponents, int player);
 
 Error returned_tokens(Game* game, Card card, int wild, Opponent* opponents, 
-        char player);
+        int player);
 
-void update_wild(Game* game, Opponent* opponents, char player);
+void update_wild(Game* game, Opponent* opponents, int player);
 
 Error set_tokens(Game* game, int numTokens);
 
 int can_afford(Card card, int* discount, int* tokens, int wild);
 
-int* get_card_cost(int* discount, int* tokens, Card card);
+int* get_card_cost(Arena* arena, int* discount, int* tokens, int wild, 
+        Card card);
 
 int sum_tokens(Card card, int* discount);
 
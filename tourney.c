@@ -0,0 +1,697 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "err.h"
+#include "common.h"
+#include "reader.h"
+#include "result.h"
+
+// default number of jobs handed to a worker at a time
+#define DEFAULT_BATCH 4
+// default hub program run by workers
+#define DEFAULT_HUB "./austerity"
+// maximum number of workers connected at once
+#define MAX_WORKERS 256
+// maximum number of fields in a job, seed tokens points deck and players
+#define JOB_FIELDS (4 + MAX_PLAYERS)
+// longest line sent between coordinator and workers
+#define TOURNEY_LINE 65536
+
+// progress of a job through the coordinator
+typedef enum {
+    JOB_PENDING,
+    JOB_ASSIGNED,
+    JOB_DONE
+} JobState;
+
+// a single game to run, line is "seed tokens points deck player ...",
+// result is held until every earlier job has been printed
+typedef struct {
+    char* line;
+    JobState state;
+    int worker;
+    char* result;
+} Job;
+
+// a worker connected to the coordinator,
+// idle workers asked for jobs when there were none to hand out
+typedef struct {
+    int fd;
+    Reader input;
+    int outstanding;
+    int idle;
+} Connection;
+
+// coordinator state, jobs are handed out in order with requeued jobs first
+// and results are printed in job order no matter which worker ran them,
+// every game of the tournament gets the same budgets, 0 for none
+typedef struct {
+    Job* jobs;
+    int numJobs;
+    int nextJob;
+    int* requeued;
+    int numRequeued;
+    int printed;
+    int batch;
+    int moveBudget;
+    int gameBudget;
+    Connection connections[MAX_WORKERS];
+    int numConnections;
+} Coordinator;
+
+/*
+ * fills in the socket address for unix:path or tcp:host:port
+ * params:  address - address to parse
+ *          local - where to save a unix address
+ *          info - where to save a tcp address, freed by the caller
+ * returns: ERR if the address is invalid,
+ *          AF_UNIX or AF_INET otherwise
+ */
+int parse_address(char* address, struct sockaddr_un* local,
+        struct addrinfo** info) {
+    if(!strncmp(address, "unix:", 5)) {
+        if(strlen(address + 5) >= sizeof(local->sun_path)) {
+            return ERR;
+        }
+        memset(local, 0, sizeof(struct sockaddr_un));
+        local->sun_family = AF_UNIX;
+        strcpy(local->sun_path, address + 5);
+        return AF_UNIX;
+    }
+
+    if(!strncmp(address, "tcp:", 4)) {
+        char host[LINE_BUFF * 4];
+        char* port = strrchr(address + 4, ':');
+        if(!port || port - (address + 4) >= (long)sizeof(host)) {
+            return ERR;
+        }
+        memcpy(host, address + 4, port - (address + 4));
+        host[port - (address + 4)] = '\0';
+        struct addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = AI_PASSIVE;
+        if(getaddrinfo(*host ? host : NULL, port + 1, &hints, info)) {
+            return ERR;
+        }
+        return AF_INET;
+    }
+
+    return ERR;
+}
+
+/*
+ * opens a listening or connected socket for the given address
+ * params:  address - unix:path or tcp:host:port
+ *          listening - 1: listen, 0: connect
+ * returns: ERR if the socket cannot be opened,
+ *          the socket otherwise
+ */
+int open_socket(char* address, int listening) {
+    struct sockaddr_un local;
+    struct addrinfo* info = NULL;
+    int family = parse_address(address, &local, &info);
+    if(family == ERR) {
+        return ERR;
+    }
+
+    struct sockaddr* addr = family == AF_UNIX ?
+            (struct sockaddr*)&local : info->ai_addr;
+    socklen_t length = family == AF_UNIX ?
+            sizeof(local) : info->ai_addrlen;
+    int fd = socket(family, SOCK_STREAM, 0);
+    int err = fd < 0;
+    if(!err && listening) {
+        int reuse = 1;
+        if(family == AF_UNIX) {
+            unlink(local.sun_path);
+        } else {
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        }
+        err = bind(fd, addr, length) || listen(fd, MAX_WORKERS);
+    } else if(!err) {
+        err = connect(fd, addr, length);
+    }
+
+    if(info) {
+        freeaddrinfo(info);
+    }
+    if(err) {
+        if(fd >= 0) {
+            close(fd);
+        }
+        return ERR;
+    }
+
+    return fd;
+}
+
+/*
+ * writes a whole line to a socket
+ * params:  fd - socket to write to
+ *          line - line to write, including the newline
+ * returns: ERR if the peer has gone,
+ *          OK otherwise
+ */
+Error send_line(int fd, char* line) {
+    size_t size = strlen(line);
+    while(size > 0) {
+        ssize_t written = write(fd, line, size);
+        if(written < 0 && errno == EINTR) {
+            continue;
+        }
+        if(written <= 0) {
+            return ERR;
+        }
+        line += written;
+        size -= (size_t)written;
+    }
+    return OK;
+}
+
+/*
+ * reads the jobs file, ignoring blank lines and lines starting with #
+ * params:  path - jobs file to read
+ *          coordinator - where to save the jobs
+ * returns: E_DECKIO if the file cannot be read,
+ *          OK otherwise
+ */
+Error read_jobs(char* path, Coordinator* coordinator) {
+    FILE* input = fopen(path, "r");
+    if(!input) {
+        return E_DECKIO;
+    }
+
+    char line[TOURNEY_LINE];
+    int capacity = 1;
+    coordinator->jobs = (Job*)malloc(sizeof(Job) * capacity);
+    coordinator->numJobs = 0;
+    while(fgets(line, TOURNEY_LINE, input)) {
+        line[strcspn(line, "\n")] = '\0';
+        if(!line[strspn(line, " \t")] || line[0] == '#') {
+            continue;
+        }
+        if(coordinator->numJobs == capacity) {
+            capacity *= 2;
+            coordinator->jobs = (Job*)realloc(coordinator->jobs,
+                    sizeof(Job) * capacity);
+        }
+        Job* job = &coordinator->jobs[coordinator->numJobs++];
+        job->line = strdup(line);
+        job->state = JOB_PENDING;
+        job->worker = ERR;
+        job->result = NULL;
+    }
+    fclose(input);
+
+    coordinator->requeued = (int*)malloc(sizeof(int) * (capacity + 1));
+    coordinator->numRequeued = 0;
+    coordinator->nextJob = 0;
+    coordinator->printed = 0;
+    return OK;
+}
+
+/*
+ * finds the next job to hand out, requeued jobs first
+ * params:  coordinator - coordinator to take the job from
+ * returns: ERR if no jobs are pending,
+ *          index of the job otherwise
+ */
+int next_job(Coordinator* coordinator) {
+    while(coordinator->numRequeued > 0) {
+        int job = coordinator->requeued[--coordinator->numRequeued];
+        if(coordinator->jobs[job].state == JOB_PENDING) {
+            return job;
+        }
+    }
+    while(coordinator->nextJob < coordinator->numJobs) {
+        int job = coordinator->nextJob++;
+        if(coordinator->jobs[job].state == JOB_PENDING) {
+            return job;
+        }
+    }
+    return ERR;
+}
+
+/*
+ * sends a batch of jobs to a worker as a "jobs n" line followed by
+ * n "job id seed tokens points deck player ..." lines,
+ * or "done" once every job has finished
+ * params:  coordinator - coordinator handing out jobs
+ *          connection - worker that asked for jobs
+ * returns: ERR if the worker has gone,
+ *          OK otherwise
+ */
+Error send_batch(Coordinator* coordinator, Connection* connection) {
+    if(coordinator->printed == coordinator->numJobs) {
+        connection->idle = 0;
+        return send_line(connection->fd, "done\n");
+    }
+
+    int batch[MAX_WORKERS];
+    int count = 0;
+    int job;
+    while(count < coordinator->batch &&
+            (job = next_job(coordinator)) != ERR) {
+        batch[count++] = job;
+    }
+    connection->idle = count == 0;
+    if(!count) {
+        return OK; // everything is out, wait for results or requeues
+    }
+
+    char line[TOURNEY_LINE + LINE_BUFF];
+    snprintf(line, sizeof(line), "jobs %d %d %d\n", count,
+            coordinator->moveBudget, coordinator->gameBudget);
+    Error err = send_line(connection->fd, line);
+    for(int i = 0; i < count; i++) {
+        Job* job = &coordinator->jobs[batch[i]];
+        job->state = JOB_ASSIGNED;
+        job->worker = (int)(connection - coordinator->connections);
+        connection->outstanding++;
+        snprintf(line, sizeof(line), "job %d %s\n", batch[i], job->line);
+        if(!err) {
+            err = send_line(connection->fd, line);
+        }
+    }
+
+    return err;
+}
+
+/*
+ * prints every finished result that has no unfinished job before it
+ * params:  coordinator - coordinator holding the results
+ */
+void print_results(Coordinator* coordinator) {
+    while(coordinator->printed < coordinator->numJobs &&
+            coordinator->jobs[coordinator->printed].state == JOB_DONE) {
+        Job* job = &coordinator->jobs[coordinator->printed++];
+        printf("%s\n", job->result);
+        free(job->result);
+        job->result = NULL;
+    }
+    fflush(stdout);
+}
+
+/*
+ * saves a "result id record" line sent by a worker,
+ * results for jobs that were already finished by another worker are dropped
+ * params:  coordinator - coordinator holding the jobs
+ *          connection - worker that sent the result
+ *          line - line sent by the worker
+ * returns: ERR if the line is invalid,
+ *          OK otherwise
+ */
+Error take_result(Coordinator* coordinator, Connection* connection,
+        char* line) {
+    char* record;
+    long id = strtol(line + strlen("result "), &record, 10);
+    if(strncmp(line, "result ", strlen("result ")) || *record != ' ' ||
+            id < 0 || id >= coordinator->numJobs) {
+        return ERR;
+    }
+
+    Job* job = &coordinator->jobs[id];
+    if(job->worker == (int)(connection - coordinator->connections)) {
+        connection->outstanding--;
+    }
+    if(job->state != JOB_DONE) {
+        job->state = JOB_DONE;
+        job->result = strdup(record + 1);
+    }
+    print_results(coordinator);
+    return OK;
+}
+
+/*
+ * disconnects a worker, putting its unfinished jobs back in the queue
+ * params:  coordinator - coordinator holding the jobs
+ *          connection - worker to drop
+ */
+void drop_worker(Coordinator* coordinator, Connection* connection) {
+    int worker = (int)(connection - coordinator->connections);
+    for(int i = coordinator->numJobs - 1;
+            connection->outstanding > 0 && i >= 0; i--) {
+        Job* job = &coordinator->jobs[i];
+        if(job->state == JOB_ASSIGNED && job->worker == worker) {
+            job->state = JOB_PENDING;
+            job->worker = ERR;
+            coordinator->requeued[coordinator->numRequeued++] = i;
+            connection->outstanding--;
+        }
+    }
+    close(connection->fd);
+    reader_destroy(&connection->input);
+    connection->fd = ERR;
+    connection->idle = 0;
+    connection->outstanding = 0;
+}
+
+/*
+ * handles every whole line a worker has sent
+ * params:  coordinator - coordinator holding the jobs
+ *          connection - worker to read from
+ * returns: ERR if the worker has gone or misbehaved,
+ *          OK otherwise
+ */
+Error serve_worker(Coordinator* coordinator, Connection* connection) {
+    if(reader_fill(&connection->input) <= 0) {
+        return ERR;
+    }
+    while(reader_has_line(&connection->input)) {
+        char* line = reader_line(&connection->input, 1, 0);
+        Error err = ERR;
+        if(!strcmp(line, "ready")) {
+            err = send_batch(coordinator, connection);
+        } else if(!strncmp(line, "result ", strlen("result "))) {
+            err = take_result(coordinator, connection, line);
+        }
+        if(err) {
+            return ERR;
+        }
+    }
+    return OK;
+}
+
+/*
+ * accepts a new worker
+ * params:  coordinator - coordinator to add the worker to
+ *          listener - listening socket
+ */
+void accept_worker(Coordinator* coordinator, int listener) {
+    int fd = accept(listener, NULL, NULL);
+    if(fd < 0) {
+        return;
+    }
+    Connection* connection = NULL;
+    for(int i = 0; i < coordinator->numConnections; i++) {
+        if(coordinator->connections[i].fd == ERR) {
+            connection = &coordinator->connections[i];
+        }
+    }
+    if(!connection && coordinator->numConnections == MAX_WORKERS) {
+        close(fd);
+        return;
+    }
+    if(!connection) {
+        connection = &coordinator->connections[coordinator->numConnections++];
+    }
+    connection->fd = fd;
+    connection->outstanding = 0;
+    connection->idle = 0;
+    reader_init(&connection->input, fd);
+}
+
+/*
+ * hands out jobs to workers until every result has been printed
+ * params:  coordinator - coordinator holding the jobs
+ *          listener - listening socket
+ */
+void coordinate(Coordinator* coordinator, int listener) {
+    struct pollfd fds[MAX_WORKERS + 1];
+    while(coordinator->printed < coordinator->numJobs) {
+        int count = 0;
+        fds[count].fd = listener;
+        fds[count++].events = POLLIN;
+        for(int i = 0; i < coordinator->numConnections; i++) {
+            fds[count].fd = coordinator->connections[i].fd; // -1 is skipped
+            fds[count++].events = POLLIN;
+        }
+        if(poll(fds, count, -1) < 0) {
+            continue;
+        }
+
+        for(int i = 0; i < coordinator->numConnections; i++) {
+            Connection* connection = &coordinator->connections[i];
+            if(connection->fd != ERR && fds[i + 1].revents &&
+                    serve_worker(coordinator, connection) != OK) {
+                drop_worker(coordinator, connection);
+            }
+        }
+        if(fds[0].revents & POLLIN) {
+            accept_worker(coordinator, listener);
+        }
+        for(int i = 0; i < coordinator->numConnections; i++) {
+            Connection* connection = &coordinator->connections[i];
+            if(connection->fd != ERR && connection->idle &&
+                    send_batch(coordinator, connection) != OK) {
+                drop_worker(coordinator, connection); // requeued jobs
+            }
+        }
+    }
+
+    for(int i = 0; i < coordinator->numConnections; i++) {
+        if(coordinator->connections[i].fd != ERR) {
+            send_line(coordinator->connections[i].fd, "done\n");
+            close(coordinator->connections[i].fd);
+            reader_destroy(&coordinator->connections[i].input);
+        }
+    }
+}
+
+/*
+ * writes the record of a job the hub gave no record for,
+ * every seat gets nothing
+ * params:  line - where to write the record
+ *          size - size of line
+ *          fields - fields of the job
+ *          numFields - number of fields in the job
+ */
+void failed_record(char* line, size_t size, char** fields, int numFields) {
+    int used = snprintf(line, size, "%s error 0 %d", RESULT_TAG,
+            numFields - 4);
+    for(int i = 4; i < numFields && used < (int)size; i++) {
+        used += snprintf(line + used, size - used, " %s:0:0:0:0", fields[i]);
+    }
+}
+
+/*
+ * runs one job with the hub and sends its result to the coordinator,
+ * SCAR_SEED is set to the seed of the job
+ * params:  fd - socket to the coordinator
+ *          hub - hub program to run
+ *          line - "id seed tokens points deck player ..."
+ *          budgets - milliseconds per move and per game, 0 for none
+ * returns: ERR if the coordinator has gone,
+ *          OK otherwise
+ */
+Error run_job(int fd, char* hub, char* line, int budgets[2]) {
+    char* fields[JOB_FIELDS + 1];
+    int numFields = 0;
+    char* save;
+    char* id = strtok_r(line, " ", &save);
+    char* field;
+    while(numFields < JOB_FIELDS && (field = strtok_r(NULL, " ", &save))) {
+        fields[numFields++] = field;
+    }
+
+    char results[] = "/tmp/tourneyXXXXXX";
+    int resultFd = mkstemp(results);
+    if(resultFd >= 0) {
+        close(resultFd);
+    }
+    pid_t pid = numFields < 6 || resultFd < 0 ? -1 : fork();
+    if(pid == 0) {
+        char* args[JOB_FIELDS + 12] = {hub, "-l", "quiet", "-r", results};
+        int numArgs = 5;
+        char budget[2][LINE_BUFF];
+        for(int i = 0; i < 2; i++) {
+            if(budgets[i]) {
+                snprintf(budget[i], LINE_BUFF, "%d", budgets[i]);
+                args[numArgs++] = i ? "-g" : "-t";
+                args[numArgs++] = budget[i];
+            }
+        }
+        memcpy(args + numArgs, fields + 1, sizeof(char*) * (numFields - 1));
+        args[numArgs + numFields - 1] = NULL;
+        setenv("SCAR_SEED", fields[0], 1);
+        int null = open("/dev/null", O_RDWR);
+        dup2(null, STDOUT_FILENO);
+        dup2(null, STDERR_FILENO);
+        execvp(hub, args);
+        _exit(E_EXEC);
+    }
+    if(pid > 0) {
+        waitpid(pid, NULL, 0);
+    }
+
+    char record[TOURNEY_LINE];
+    record[0] = '\0';
+    FILE* input = resultFd >= 0 ? fopen(results, "r") : NULL;
+    if(input) {
+        if(!fgets(record, TOURNEY_LINE, input)) {
+            record[0] = '\0';
+        }
+        fclose(input);
+    }
+    if(resultFd >= 0) {
+        unlink(results);
+    }
+    record[strcspn(record, "\n")] = '\0';
+    if(!record[0]) {
+        failed_record(record, TOURNEY_LINE, fields, numFields);
+    }
+
+    char reply[TOURNEY_LINE + LINE_BUFF];
+    snprintf(reply, sizeof(reply), "result %s %s\n", id, record);
+    return send_line(fd, reply);
+}
+
+/*
+ * asks the coordinator for batches of jobs and runs them one at a time,
+ * sending each result as soon as it is known
+ * params:  address - address of the coordinator
+ *          hub - hub program to run
+ * returns: E_COMMERR if the coordinator cannot be reached or goes away,
+ *          OK once the coordinator has no more jobs
+ */
+Error work(char* address, char* hub) {
+    int fd = open_socket(address, 0);
+    if(fd == ERR) {
+        return E_COMMERR;
+    }
+    Reader input;
+    reader_init(&input, fd);
+
+    Error err = OK;
+    char* line = NULL;
+    while(!err && send_line(fd, "ready\n") == OK &&
+            (line = reader_line(&input, 1, 0)) && strcmp(line, "done")) {
+        int count = 0;
+        int budgets[2] = {0, 0};
+        if(sscanf(line, "jobs %d %d %d", &count, &budgets[0], 
+                &budgets[1]) != 3 || count < 0 || count > MAX_WORKERS ||
+                budgets[0] < 0 || budgets[1] < 0) {
+            err = E_COMMERR;
+        }
+        char* jobs[MAX_WORKERS];
+        for(int i = 0; !err && i < count; i++) {
+            line = reader_line(&input, 1, 0);
+            if(!line || strncmp(line, "job ", strlen("job "))) {
+                err = E_COMMERR;
+                count = i;
+                break;
+            }
+            jobs[i] = strdup(line + strlen("job "));
+        }
+        for(int i = 0; i < count; i++) {
+            if(!err && run_job(fd, hub, jobs[i], budgets) != OK) {
+                err = E_COMMERR;
+            }
+            free(jobs[i]);
+        }
+    }
+    if(!err && !line) {
+        err = E_COMMERR;
+    }
+
+    reader_destroy(&input);
+    close(fd);
+    return err;
+}
+
+/*
+ * prints usage of tourney to stderr
+ * returns: E_ARGC
+ */
+Error usage(void) {
+    fprintf(stderr, "Usage: tourney [-b batch] [-w workers] [-H hub] "
+            "[-t milliseconds] [-g milliseconds] serve address jobs\n"
+            "       tourney [-H hub] work address\n");
+    return E_ARGC;
+}
+
+/*
+ * runs a tournament, in serve mode the jobs file is handed out to workers
+ * and their results printed in job order, -w starts local workers;
+ * in work mode jobs are taken from a coordinator and run with the hub
+ */
+int main(int argc, char** argv) {
+    static Coordinator coordinator;
+    coordinator.batch = DEFAULT_BATCH;
+    int localWorkers = 0;
+    char* hub = DEFAULT_HUB;
+    int option;
+    while((option = getopt(argc, argv, "+b:w:H:t:g:")) != -1) {
+        switch(option) {
+            case 'b':
+                coordinator.batch = atoi(optarg);
+                break;
+            case 'w':
+                localWorkers = atoi(optarg);
+                break;
+            case 'H':
+                hub = optarg;
+                break;
+            case 't':
+                coordinator.moveBudget = atoi(optarg);
+                break;
+            case 'g':
+                coordinator.gameBudget = atoi(optarg);
+                break;
+            default:
+                return usage();
+        }
+    }
+    if(coordinator.batch < 1 || coordinator.batch > MAX_WORKERS ||
+            localWorkers < 0 || localWorkers > MAX_WORKERS ||
+            coordinator.moveBudget < 0 || coordinator.gameBudget < 0) {
+        return usage();
+    }
+    signal(SIGPIPE, SIG_IGN); // gone peers show up as write errors
+
+    if(argc - optind == 2 && !strcmp(argv[optind], "work")) {
+        Error err = work(argv[optind + 1], hub);
+        if(err) {
+            fprintf(stderr, "Lost coordinator\n");
+        }
+        return err;
+    }
+    if(argc - optind != 3 || strcmp(argv[optind], "serve")) {
+        return usage();
+    }
+
+    if(read_jobs(argv[optind + 2], &coordinator) != OK) {
+        fprintf(stderr, "Cannot access jobs file\n");
+        return E_DECKIO;
+    }
+    int listener = open_socket(argv[optind + 1], 1);
+    if(listener == ERR) {
+        fprintf(stderr, "Cannot listen on %s\n", argv[optind + 1]);
+        return E_COMMERR;
+    }
+
+    for(int i = 0; i < localWorkers; i++) {
+        if(fork() == 0) {
+            close(listener);
+            exit(work(argv[optind + 1], hub));
+        }
+    }
+
+    coordinate(&coordinator, listener);
+    close(listener);
+    if(!strncmp(argv[optind + 1], "unix:", 5)) {
+        unlink(argv[optind + 1] + 5);
+    }
+    while(wait(NULL) > 0) {
+        ; // local workers leave once told there is nothing left
+    }
+
+    for(int i = 0; i < coordinator.numJobs; i++) {
+        free(coordinator.jobs[i].line);
+    }
+    free(coordinator.jobs);
+    free(coordinator.requeued);
+    return OK;
+}
@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include "trace.h"
+
+// spans recorded by this process, written out as chrome trace events
+// on exit by the process that opened the tracer
+typedef struct {
+    int on;
+    pid_t owner;
+    char* path;
+    char process[64];
+    TraceSpan* ring;
+    uint64_t count;     // total spans ever recorded
+} Tracer;
+
+static Tracer tracer; // zeroed, so off until opened
+
+/*
+ * reads the monotonic clock, which all processes share
+ * returns: nanoseconds since an arbitrary point
+ */
+uint64_t trace_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+/*
+ * turns tracing on if TRACE_ENV names a file, the spans are appended 
+ * to it on exit as a chrome trace in the json array format,
+ * which may be left without its closing bracket
+ * params:  process - name shown for this process in the trace
+ *          fresh - 1: start the file over, for the hub,
+ *                  0: append to it, for players
+ */
+void trace_open(const char* process, int fresh) {
+    char* path = getenv(TRACE_ENV);
+    if(!path || !*path || (tracer.on && tracer.owner == getpid())) {
+        return;
+    }
+    if(tracer.on) { // forked from a traced process without an exec
+        free(tracer.ring);
+    }
+
+    if(fresh) {
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(fd < 0 || write(fd, "[\n", 2) != 2) {
+            if(fd >= 0) {
+                close(fd);
+            }
+            return;
+        }
+        close(fd);
+    }
+
+    tracer.ring = (TraceSpan*)malloc(sizeof(TraceSpan) * TRACE_RING);
+    tracer.path = path;
+    tracer.owner = getpid();
+    snprintf(tracer.process, sizeof(tracer.process), "%s", process);
+    tracer.count = 0;
+    tracer.on = 1;
+    atexit(&trace_flush);
+}
+
+/*
+ * starts a span
+ * returns: start of the span, 0 when tracing is off
+ */
+uint64_t trace_begin(void) {
+    return tracer.on ? trace_now() : 0;
+}
+
+/*
+ * ends a span started by trace_begin
+ * params:  name - what the span was spent on, must outlive the process
+ *          start - value returned by trace_begin
+ */
+void trace_end(const char* name, uint64_t start) {
+    if(!tracer.on) {
+        return;
+    }
+
+    TraceSpan* span = &tracer.ring[tracer.count++ & (TRACE_RING - 1)];
+    span->name = name;
+    span->start = start;
+    span->duration = trace_now() - start;
+}
+
+/*
+ * appends the recorded spans to the trace file in blocks of whole events,
+ * so the events of processes writing at the same time do not interleave,
+ * children forked from the owner before exec write nothing
+ */
+void trace_flush(void) {
+    if(!tracer.on || getpid() != tracer.owner) {
+        return;
+    }
+    tracer.on = 0;
+
+    int fd = open(tracer.path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if(fd < 0) {
+        free(tracer.ring);
+        return;
+    }
+
+    size_t size = 1 << 16;
+    char* block = (char*)malloc(size);
+    int pid = (int)tracer.owner;
+    size_t used = snprintf(block, size, "{\"name\":\"process_name\","
+            "\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+            "\"args\":{\"name\":\"%s\"}},\n", pid, pid, tracer.process);
+    uint64_t first = tracer.count > TRACE_RING ? tracer.count - TRACE_RING : 0;
+    for(uint64_t i = first; i < tracer.count; i++) {
+        if(used > size - TRACE_EVENT) {
+            if(write(fd, block, used) != (ssize_t)used) {
+                break;
+            }
+            used = 0;
+        }
+
+        TraceSpan* span = &tracer.ring[i & (TRACE_RING - 1)];
+        used += snprintf(block + used, size - used, "{\"name\":\"%s\","
+                "\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%llu.%03llu,"
+                "\"dur\":%llu.%03llu},\n", span->name, pid, pid, 
+                (unsigned long long)(span->start / 1000), 
+                (unsigned long long)(span->start % 1000),
+                (unsigned long long)(span->duration / 1000), 
+                (unsigned long long)(span->duration % 1000));
+    }
+    if(used && write(fd, block, used) != (ssize_t)used) {
+        fprintf(stderr, "Trace incomplete\n");
+    }
+
+    close(fd);
+    free(block);
+    free(tracer.ring);
+}
@@ -0,0 +1,29 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+// environment variable naming the trace file, tracing is off without it
+#define TRACE_ENV "AUSTERITY_TRACE"
+// spans kept by each process, the oldest are overwritten, a power of 2
+#define TRACE_RING (1 << 16)
+// longest span once formatted as a trace event
+#define TRACE_EVENT 192
+
+// a finished span of work on the main thread, 
+// start is CLOCK_MONOTONIC so spans of all processes line up
+typedef struct {
+    const char* name;
+    uint64_t start;
+    uint64_t duration;
+} TraceSpan;
+
+void trace_open(const char* process, int fresh);
+
+uint64_t trace_begin(void);
+
+void trace_end(const char* name, uint64_t start);
+
+void trace_flush(void);
+
+#endif
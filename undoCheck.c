@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "err.h"
+#include "common.h"
+#include "card.h"
+#include "playerCommon.h"
+#include "moves.h"
+#include "rng.h"
+
+// random games played out and taken back
+#define UNDO_GAMES 200000
+// most moves played in a game before it is taken back
+#define UNDO_DEPTH 32
+// most players in a game, every game has 2 or more
+#define UNDO_PLAYERS 6
+// seed of the games, the same seed plays the same games
+#define UNDO_SEED 1
+// failed games printed before the rest are only counted
+#define MAX_REPORTS 10
+
+// everything apply_move may change: the bank, the board's pointers and
+// the cards they point at, the number of cards and every player
+typedef struct {
+    int tokens[TOKEN_SIZE];
+    int numCards;
+    Card deck[BOARD_SIZE];
+    int cards[BOARD_SIZE * CARD_SIZE];
+    Opponent opponents[UNDO_PLAYERS];
+} Snapshot;
+
+// a game played on by apply_move, the board points into cards
+typedef struct {
+    Game game;
+    Card deck[BOARD_SIZE];
+    int cards[BOARD_SIZE * CARD_SIZE];
+    Opponent opponents[UNDO_PLAYERS];
+} Position;
+
+// purchases made from each slot of the board over every game
+long slotPurchases[BOARD_SIZE];
+// games whose moves were not all taken back
+long failed = 0;
+
+/*
+ * deals a random position, boards of every size up to BOARD_SIZE and
+ * players who can afford some of it
+ * params:  position - position to deal
+ *          rng - source of the position
+ */
+void deal_position(Position* position, Rng* rng) {
+    Game* game = &position->game;
+    memset(position, 0, sizeof(Position));
+    game->pCount = 2 + rng_range(rng, UNDO_PLAYERS - 1);
+    game->stack.numCards = rng_range(rng, BOARD_SIZE + 1);
+    game->stack.deck = position->deck;
+    for(int i = 0; i < BOARD_SIZE; i++) {
+        Card card = position->cards + i * CARD_SIZE;
+        card[COLOR] = "PBYR"[rng_range(rng, TOKEN_SIZE)];
+        card[POINTS] = rng_range(rng, 4);
+        for(int j = 0; j < TOKEN_SIZE; j++) {
+            card[PURPLE + j] = rng_range(rng, 3);
+        }
+        position->deck[i] = card;
+    }
+    for(int i = 0; i < TOKEN_SIZE; i++) {
+        game->tokens[i] = rng_range(rng, 6);
+    }
+    for(int i = 0; i < game->pCount; i++) {
+        Opponent* player = &position->opponents[i];
+        player->id = i;
+        player->numPoints = rng_range(rng, 10);
+        player->wild = rng_range(rng, 3);
+        for(int j = 0; j < TOKEN_SIZE; j++) {
+            player->tokens[j] = rng_range(rng, 4);
+            player->discount[j] = rng_range(rng, 2);
+        }
+    }
+}
+
+/*
+ * saves everything apply_move may change
+ * params:  position - position to save
+ *          snapshot - where to save it
+ */
+void take_snapshot(Position* position, Snapshot* snapshot) {
+    memset(snapshot, 0, sizeof(Snapshot));
+    memcpy(snapshot->tokens, position->game.tokens,
+            sizeof(int) * TOKEN_SIZE);
+    snapshot->numCards = position->game.stack.numCards;
+    memcpy(snapshot->deck, position->deck, sizeof(Card) * BOARD_SIZE);
+    memcpy(snapshot->cards, position->cards,
+            sizeof(int) * BOARD_SIZE * CARD_SIZE);
+    memcpy(snapshot->opponents, position->opponents,
+            sizeof(Opponent) * UNDO_PLAYERS);
+}
+
+/*
+ * picks a random legal move, purchases are made half the time one can
+ * be so the board is bought from often
+ * params:  moves - moves listed by legal_moves, purchases first
+ *          count - number of moves listed
+ *          rng - source of the choice
+ * returns: chosen move
+ */
+Move* choose_move(Move* moves, int count, Rng* rng) {
+    int purchases = 0;
+    while(purchases < count && moves[purchases].type == PURCHASE) {
+        purchases++;
+    }
+    if(purchases && rng_range(rng, 2)) {
+        return &moves[rng_range(rng, purchases)];
+    }
+    return &moves[rng_range(rng, count)];
+}
+
+/*
+ * plays a random sequence of legal moves and takes each back in turn,
+ * checking the position is as it was before the move
+ * params:  position - position to play on
+ *          rng - source of the moves
+ * returns: ERR if a move was not taken back exactly,
+ *          OK otherwise
+ */
+Error check_game(Position* position, Rng* rng) {
+    static Snapshot snapshots[UNDO_DEPTH];
+    Undo undo[UNDO_DEPTH];
+    Game* game = &position->game;
+    int depth = 1 + rng_range(rng, UNDO_DEPTH);
+    int mover = rng_range(rng, game->pCount);
+    for(int i = 0; i < depth; i++, mover = (mover + 1) % game->pCount) {
+        Opponent* player = &position->opponents[mover];
+        Move moves[MAX_MOVES];
+        int count = legal_moves(game->tokens, &game->stack,
+                player->discount, player->tokens, player->wild, moves);
+        Move* move = choose_move(moves, count, rng);
+        if(move->type == PURCHASE) {
+            slotPurchases[move->card]++;
+        }
+        take_snapshot(position, &snapshots[i]);
+        apply_move(game, player, move, &undo[i]);
+    }
+
+    for(int i = depth - 1; i > -1; i--) {
+        Snapshot now;
+        undo_move(game, &undo[i]);
+        take_snapshot(position, &now);
+        if(memcmp(&now, &snapshots[i], sizeof(Snapshot))) {
+            if(failed++ >= MAX_REPORTS) {
+                return ERR;
+            }
+            fprintf(stderr, "move %d of %d, type %d card %d, "
+                    "not taken back\n", i, depth, undo[i].move.type,
+                    undo[i].move.card);
+            return ERR;
+        }
+    }
+
+    return OK;
+}
+
+int main(void) {
+    Rng rng;
+    rng_seed(&rng, UNDO_SEED);
+    static Position position;
+    for(long i = 0; i < UNDO_GAMES; i++) {
+        deal_position(&position, &rng);
+        check_game(&position, &rng);
+    }
+
+    printf("took back %d games, %ld failed; purchases by slot:",
+            UNDO_GAMES, failed);
+    for(int i = 0; i < BOARD_SIZE; i++) {
+        printf(" %ld", slotPurchases[i]);
+        failed += !slotPurchases[i]; // every slot must have been bought
+    }
+    printf("\n");
+
+    return failed ? ERR : OK;
+}
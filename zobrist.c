@@ -0,0 +1,259 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "err.h"
+#include "common.h"
+#include "card.h"
+#include "comms.h"
+#include "playerCommon.h"
+#include "moves.h"
+#include "rng.h"
+#include "zobrist.h"
+
+/*
+ * gives the key of one value of one part of a position, 
+ * keys are worked out as needed so values have no upper bound
+ * params:  part - part of the position
+ *          index - which one of the part, player * TOKEN_SIZE + colour
+ *                  for the parts of a player
+ *          value - value of the part
+ * returns: 64 bit key
+ */
+uint64_t zobrist_key(ZobristPart part, int index, int value) {
+    return mix64(((uint64_t)part << 56) ^ 
+            ((uint64_t)(uint32_t)index << 32) ^ (uint64_t)(uint32_t)value);
+}
+
+/*
+ * gives the key of a card on the board, equal cards have equal keys
+ * params:  card - card to key
+ * returns: 64 bit key
+ */
+uint64_t zobrist_card(Card card) {
+    uint64_t key = zobrist_key(ZOBRIST_CARD, 0, 0);
+    for(int i = 0; i < CARD_SIZE; i++) {
+        key = mix64(key ^ (uint32_t)card[i]);
+    }
+
+    return key;
+}
+
+/*
+ * changes the value of one part of a hash
+ * params:  hash - hash to change
+ *          part - part of the position that changed
+ *          index - which one of the part
+ *          from - old value
+ *          to - new value
+ * returns: the changed hash
+ */
+uint64_t zobrist_change(uint64_t hash, ZobristPart part, int index, 
+        int from, int to) {
+    if(from == to) {
+        return hash;
+    }
+
+    return hash - zobrist_key(part, index, from) + 
+            zobrist_key(part, index, to);
+}
+
+/*
+ * hashes a whole position, the bank, the board and every player
+ * params:  game - position to hash
+ *          opponents - stats of every player
+ *          pCount - number of players
+ * returns: 64 bit hash of the position
+ */
+uint64_t zobrist_position(Game* game, Opponent* opponents, int pCount) {
+    uint64_t hash = 0;
+    for(int i = 0; i < TOKEN_SIZE; i++) {
+        hash += zobrist_key(ZOBRIST_BANK, i, game->tokens[i]);
+    }
+    for(int i = 0; i < game->stack.numCards; i++) {
+        hash += zobrist_card(game->stack.deck[i]);
+    }
+    for(int p = 0; p < pCount; p++) {
+        Opponent* player = &opponents[p];
+        for(int i = 0; i < TOKEN_SIZE; i++) {
+            hash += zobrist_key(ZOBRIST_TOKENS, p * TOKEN_SIZE + i, 
+                    player->tokens[i]);
+            hash += zobrist_key(ZOBRIST_DISCOUNT, p * TOKEN_SIZE + i, 
+                    player->discount[i]);
+        }
+        hash += zobrist_key(ZOBRIST_WILD, p, player->wild);
+        hash += zobrist_key(ZOBRIST_POINTS, p, player->numPoints);
+    }
+
+    return hash;
+}
+
+/*
+ * works out the hash of a position after a move in constant time,
+ * must be called before the move is applied
+ * params:  hash - hash of the position before the move
+ *          game - position before the move
+ *          player - stats of the player moving
+ *          move - legal move to be played
+ * returns: hash of the position after the move
+ */
+uint64_t zobrist_move(uint64_t hash, Game* game, Opponent* player, 
+        Move* move) {
+    int p = player->id;
+    if(move->type == WILD) {
+        return zobrist_change(hash, ZOBRIST_WILD, p, player->wild, 
+                player->wild + 1);
+    }
+
+    int sign = move->type == TAKE ? 1 : -1; // purchases pay tokens back
+    for(int i = 0; i < TOKEN_SIZE; i++) {
+        int tokens = move->tokens[i] * sign;
+        hash = zobrist_change(hash, ZOBRIST_BANK, i, game->tokens[i], 
+                game->tokens[i] - tokens);
+        hash = zobrist_change(hash, ZOBRIST_TOKENS, p * TOKEN_SIZE + i, 
+                player->tokens[i], player->tokens[i] + tokens);
+    }
+    if(move->type == TAKE) {
+        return hash;
+    }
+
+    Card card = game->stack.deck[move->card];
+    int colour = discount_index(card[COLOR]);
+    hash = zobrist_change(hash, ZOBRIST_WILD, p, player->wild, 
+            player->wild - move->wild);
+    hash = zobrist_change(hash, ZOBRIST_DISCOUNT, p * TOKEN_SIZE + colour, 
+            player->discount[colour], player->discount[colour] + 1);
+    hash = zobrist_change(hash, ZOBRIST_POINTS, p, player->numPoints, 
+            player->numPoints + card[POINTS]);
+    return hash - zobrist_card(card);
+}
+
+/*
+ * allocates an empty transposition table, its number of entries is the 
+ * largest power of two that fits
+ * params:  table - table to set up
+ *          megabytes - memory to use
+ * returns: ERR if the memory could not be allocated,
+ *          OK otherwise
+ */
+Error trans_init(TransTable* table, size_t megabytes) {
+    memset(table, 0, sizeof(TransTable));
+    if(!megabytes) {
+        return ERR;
+    }
+    size_t count = 1;
+    while(count * 2 * sizeof(TransEntry) <= megabytes << 20) {
+        count *= 2;
+    }
+
+    table->entries = (TransEntry*)calloc(count, sizeof(TransEntry));
+    if(!table->entries) {
+        return ERR;
+    }
+    table->mask = count - 1;
+    return OK;
+}
+
+/*
+ * looks up the results summed for a position, they are only of use if 
+ * there are more of them than the caller has itself
+ * params:  table - table to look in, may have no entries
+ *          counts - counts of the calling thread
+ *          key - hash of the position
+ *          known - number of results the caller already has
+ *          visits - where to save the number of results
+ *          score - where to save the summed results
+ * returns: 1 if the position was found with more than known results,
+ *          0 otherwise
+ */
+int trans_probe(TransTable* table, TransCounts* counts, uint64_t key, 
+        int known, int* visits, double* score) {
+    if(!table->entries) {
+        return 0;
+    }
+
+    TransEntry* entry = &table->entries[key & table->mask];
+    uint64_t data = __atomic_load_n(&entry->data, __ATOMIC_RELAXED);
+    uint64_t check = __atomic_load_n(&entry->check, __ATOMIC_RELAXED);
+    counts->probes++;
+    if(!data || (check ^ data) != key || 
+            (int)(data & 0xffffffffULL) <= known) {
+        return 0;
+    }
+
+    counts->hits++;
+    *visits = (int)(data & 0xffffffffULL);
+    *score = (double)(data >> 32) / TRANS_SCALE;
+    return 1;
+}
+
+/*
+ * adds a result to a position, taking the slot from any other position,
+ * a result racing another thread's on the same slot may be lost 
+ * but never mixed into a different position
+ * params:  table - table to add to, may have no entries
+ *          counts - counts of the calling thread
+ *          key - hash of the position
+ *          reward - result between 0 and 1
+ */
+void trans_add(TransTable* table, TransCounts* counts, uint64_t key, 
+        double reward) {
+    if(!table->entries) {
+        return;
+    }
+
+    TransEntry* entry = &table->entries[key & table->mask];
+    uint64_t data = __atomic_load_n(&entry->data, __ATOMIC_RELAXED);
+    uint64_t check = __atomic_load_n(&entry->check, __ATOMIC_RELAXED);
+    uint64_t scaled = (uint64_t)(reward * TRANS_SCALE + 0.5);
+    if(data && (check ^ data) == key) {
+        data += 1 + (scaled << 32);
+    } else {
+        if(data) {
+            counts->collisions++;
+        }
+        data = 1 + (scaled << 32);
+    }
+    counts->stores++;
+    __atomic_store_n(&entry->data, data, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->check, key ^ data, __ATOMIC_RELAXED);
+}
+
+/*
+ * prints the size of the table and how well it has been hit,
+ * summing the counts of every thread that used it
+ * params:  table - table to report on
+ *          counts - array of the counts of each thread
+ *          numCounts - number of threads
+ *          output - where to print
+ */
+void trans_report(TransTable* table, TransCounts* counts, int numCounts,
+        FILE* output) {
+    if(!table->entries) {
+        return;
+    }
+
+    TransCounts total = {0, 0, 0, 0};
+    for(int i = 0; i < numCounts; i++) {
+        total.probes += counts[i].probes;
+        total.hits += counts[i].hits;
+        total.stores += counts[i].stores;
+        total.collisions += counts[i].collisions;
+    }
+    fprintf(output, "Table of %lluKB: %llu probes, %.1f%% hits, "
+            "%llu stores, %llu collisions\n", 
+            (unsigned long long)((table->mask + 1) * sizeof(TransEntry) >> 10),
+            (unsigned long long)total.probes, 
+            total.probes ? 100.0 * total.hits / total.probes : 0.0,
+            (unsigned long long)total.stores, 
+            (unsigned long long)total.collisions);
+}
+
+/*
+ * frees the entries of a table
+ * params:  table - table to free
+ */
+void trans_destroy(TransTable* table) {
+    free(table->entries);
+    table->entries = NULL;
+}
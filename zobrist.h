@@ -0,0 +1,77 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "err.h"
+#include "common.h"
+#include "playerCommon.h"
+#include "moves.h"
+
+// default size of a transposition table in megabytes
+#define TRANS_MEGABYTES 16
+// fixed point scale rewards are summed with in a table entry
+#define TRANS_SCALE 1024
+
+// parts of a position that are hashed, every value of every part has 
+// its own key, the hash of a position is the sum of the keys of its parts
+// so a move changes it by adding the new keys and taking the old ones away
+typedef enum {
+    ZOBRIST_BANK,       // tokens of a colour left in the bank
+    ZOBRIST_TOKENS,     // tokens of a colour owned by a player
+    ZOBRIST_DISCOUNT,   // discount of a colour owned by a player
+    ZOBRIST_WILD,       // wild tokens owned by a player
+    ZOBRIST_POINTS,     // points of a player
+    ZOBRIST_CARD,       // a card on the board, wherever it is
+    ZOBRIST_MOVER       // the player to move next
+} ZobristPart;
+
+// an entry of a transposition table, check is the key xor'd with data
+// so an entry torn by two threads writing at once never matches,
+// data holds the visits in its low half and the summed reward above
+typedef struct {
+    uint64_t check;
+    uint64_t data;
+} TransEntry;
+
+// transposition table shared by search threads without locks,
+// results of positions are summed under their hash, 
+// a position whose slot is taken replaces it
+typedef struct {
+    TransEntry* entries;
+    uint64_t mask;
+} TransTable;
+
+// how one search thread has used a table, kept by the thread so the
+// counts are never written by two threads, hits are probes that found 
+// more results than the thread already had for the position
+typedef struct {
+    uint64_t probes;
+    uint64_t hits;
+    uint64_t stores;
+    uint64_t collisions;
+} TransCounts;
+
+uint64_t zobrist_key(ZobristPart part, int index, int value);
+
+uint64_t zobrist_card(Card card);
+
+uint64_t zobrist_position(Game* game, Opponent* opponents, int pCount);
+
+uint64_t zobrist_move(uint64_t hash, Game* game, Opponent* player, 
+        Move* move);
+
+Error trans_init(TransTable* table, size_t megabytes);
+
+int trans_probe(TransTable* table, TransCounts* counts, uint64_t key, 
+        int known, int* visits, double* score);
+
+void trans_add(TransTable* table, TransCounts* counts, uint64_t key, 
+        double reward);
+
+void trans_report(TransTable* table, TransCounts* counts, int numCounts,
+        FILE* output);
+
+void trans_destroy(TransTable* table);
+
+#endif
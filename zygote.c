@@ -0,0 +1,309 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+#include <dlfcn.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/prctl.h>
+#include "err.h"
+#include "common.h"
+#include "card.h"
+#include "playerCommon.h"
+#include "signalHandler.h"
+#include "plugin.h"
+#include "placement.h"
+#include "process.h"
+#include "zygote.h"
+
+// a player program the zygote has loaded, strategy is NULL if it
+// has no plugin and has to be exec'd by the hub instead
+typedef struct {
+    char path[ZYGOTE_PATH];
+    Strategy* strategy;
+} Preload;
+
+// in the hub the end of the socket to the zygote, in the zygote the
+// end to the hub, -1 if there is no zygote
+static int zygoteSocket = -1;
+static pid_t zygotePID = 0;
+
+// programs loaded by the zygote so far
+static Preload preloads[ZYGOTE_PROGRAMS];
+static int preloadCount = 0;
+
+/*
+ * finds the strategy of a player program in the plugin beside it,
+ * ./shenzi is played by ./shenzi.so, loading it the first time
+ * it is asked for
+ * params:  program - player program the hub would exec
+ * returns: NULL if the program has no usable plugin,
+ *          the strategy of the program otherwise
+ */
+static Strategy* zygote_strategy(char* program) {
+    for(int i = 0; i < preloadCount; i++) {
+        if(!strcmp(preloads[i].path, program)) {
+            return preloads[i].strategy;
+        }
+    }
+
+    Strategy* strategy = NULL;
+    char path[ZYGOTE_PATH + sizeof(PLUGIN_SUFFIX)];
+    snprintf(path, sizeof(path), "%s%s", program, PLUGIN_SUFFIX);
+    void* library = strchr(program, '/') ?
+            dlopen(path, RTLD_NOW | RTLD_LOCAL) : NULL;
+    if(library) { // kept open for every later fork
+        strategy = (Strategy*)dlsym(library, PLUGIN_SYMBOL);
+        if(!strategy || strategy->abi != PLUGIN_ABI || !strategy->move) {
+            strategy = NULL;
+        }
+    }
+
+    if(preloadCount < ZYGOTE_PROGRAMS) {
+        strcpy(preloads[preloadCount].path, program);
+        preloads[preloadCount++].strategy = strategy;
+    }
+    return strategy;
+}
+
+/*
+ * plays a game as a player forked by the zygote,
+ * the same way the player program would after its exec
+ * params:  strategy - strategy of the player program
+ *          request - the player to be
+ *          fds - the player's ends of its stdin and stdout pipes
+ *          options - hub options capping the player
+ * returns: does not return, exits with the status of the program
+ */
+static void zygote_play(Strategy* strategy, ZygoteRequest* request,
+        int fds[2], Options* options) {
+    dup2(fds[0], STDIN_FILENO);
+    dup2(fds[1], STDOUT_FILENO);
+    close(STDERR_FILENO);
+    close(fds[0]);
+    close(fds[1]);
+    close(zygoteSocket);
+    char* name = strrchr(request->program, '/');
+    prctl(PR_SET_NAME, name ? name + 1 : request->program);
+    place_player(options->placement, 0, request->pID, request->pCount);
+    limit_player(options, 0);
+
+    Game game;
+    init_player_game(request->pID, request->pCount, &game);
+    Error err = strategy->init ? strategy->init(&game) : OK;
+    if(!err) {
+        int signalList[] = {SIGPIPE};
+        init_signal_handler(signalList, 1);
+        err = play_game(&game, strategy->move, strategy->speculate);
+        if(strategy->shred) {
+            strategy->shred(&game);
+        }
+    }
+    if(err == UTIL) {
+        err = OK;
+    }
+    if(err == ERR) {
+        err = E_COMMERR;
+    }
+
+    shred_player_game(&game);
+    exit(err);
+}
+
+/*
+ * forks a player twice so that it is orphaned to the hub,
+ * which is its subreaper, and can be waited for there like any other
+ * params:  strategy - strategy of the player program
+ *          request - the player to fork
+ *          fds - the player's ends of its stdin and stdout pipes
+ *          options - hub options capping the player
+ * returns: -1 if the player could not be forked,
+ *          pid of the player otherwise, which the hub now owns
+ */
+static pid_t zygote_fork(Strategy* strategy, ZygoteRequest* request,
+        int fds[2], Options* options) {
+    int status[2];
+    if(pipe(status) < 0) {
+        return -1;
+    }
+
+    pid_t middle = fork();
+    if(middle == 0) {
+        close(status[READ]);
+        pid_t player = fork();
+        if(player == 0) {
+            close(status[WRITE]);
+            zygote_play(strategy, request, fds, options);
+        }
+        if(write(status[WRITE], &player, sizeof(pid_t)) != sizeof(pid_t)) {
+            _exit(E_EXEC);
+        }
+        _exit(OK);
+    }
+
+    pid_t player = -1;
+    close(status[WRITE]);
+    if(middle > 0) { // the player is the hub's once middle is gone
+        if(read(status[READ], &player, sizeof(pid_t)) != sizeof(pid_t)) {
+            player = -1;
+        }
+        waitpid(middle, NULL, 0);
+    }
+    close(status[READ]);
+    return player;
+}
+
+/*
+ * reads a request from the hub along with the pipes of the player
+ * params:  request - where to save the request
+ *          fds - where to save the player's ends of its pipes
+ * returns: ERR if the hub is gone or sent something else,
+ *          OK otherwise
+ */
+static Error zygote_receive(ZygoteRequest* request, int fds[2]) {
+    char control[CMSG_SPACE(sizeof(int) * 2)];
+    struct iovec part = {request, sizeof(ZygoteRequest)};
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &part;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    ssize_t got = recvmsg(zygoteSocket, &message, 0);
+    struct cmsghdr* fdPart = got > 0 ? CMSG_FIRSTHDR(&message) : NULL;
+    if(!fdPart || fdPart->cmsg_type != SCM_RIGHTS ||
+            fdPart->cmsg_len != CMSG_LEN(sizeof(int) * 2)) {
+        return ERR;
+    }
+    memcpy(fds, CMSG_DATA(fdPart), sizeof(int) * 2);
+    if(got != sizeof(ZygoteRequest)) {
+        close(fds[0]);
+        close(fds[1]);
+        return ERR;
+    }
+    request->program[ZYGOTE_PATH - 1] = '\0';
+    return OK;
+}
+
+/*
+ * forks players for the hub until it closes its socket
+ * params:  options - hub options capping the players
+ * returns: does not return, exits once the hub is gone
+ */
+static void zygote_serve(Options* options) {
+    ZygoteRequest request;
+    int fds[2];
+    while(zygote_receive(&request, fds) == OK) {
+        Strategy* strategy = zygote_strategy(request.program);
+        pid_t player = strategy ?
+                zygote_fork(strategy, &request, fds, options) : -1;
+        close(fds[0]);
+        close(fds[1]);
+        if(send(zygoteSocket, &player, sizeof(pid_t), 0) != sizeof(pid_t)) {
+            break;
+        }
+    }
+    _exit(OK);
+}
+
+/*
+ * forks the zygote, which loads player programs once and forks
+ * ready players from then on, saving the hub an exec per player,
+ * the hub becomes the subreaper of the players so it still reaps them
+ * params:  options - hub options capping the players
+ * returns: E_EXEC if the zygote could not be started,
+ *          OK otherwise
+ */
+Error zygote_start(Options* options) {
+    int sockets[2];
+    if(prctl(PR_SET_CHILD_SUBREAPER, 1) || socketpair(AF_UNIX,
+            SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets)) {
+        return E_EXEC;
+    }
+
+    fflush(NULL); // nothing buffered by the hub is written twice
+    pid_t pid = fork();
+    if(pid < 0) {
+        close(sockets[0]);
+        close(sockets[1]);
+        return E_EXEC;
+    }
+    if(pid == 0) {
+        close(sockets[0]);
+        zygoteSocket = sockets[1];
+        zygote_serve(options);
+    }
+    close(sockets[1]);
+    zygoteSocket = sockets[0];
+    zygotePID = pid;
+    return OK;
+}
+
+/*
+ * lets the zygote exit and reaps it, players it forked are left running
+ */
+void zygote_stop(void) {
+    if(zygoteSocket >= 0) {
+        close(zygoteSocket);
+        zygoteSocket = -1;
+    }
+    if(zygotePID > 0) {
+        while(waitpid(zygotePID, NULL, 0) < 0 && errno == EINTR) {
+        }
+        zygotePID = 0;
+    }
+}
+
+/*
+ * asks the zygote for a player, the hub keeps its own ends of the pipes
+ * params:  program - player program the hub would exec
+ *          pCount - number of players
+ *          pID - seat of the player
+ *          input - read end of the player's stdin pipe
+ *          output - write end of the player's stdout pipe
+ * returns: 0 if the player has to be exec'd by the hub instead,
+ *          pid of the player otherwise
+ */
+pid_t zygote_spawn(char* program, int pCount, int pID, int input,
+        int output) {
+    if(zygoteSocket < 0 || strlen(program) >= ZYGOTE_PATH) {
+        return 0;
+    }
+
+    ZygoteRequest request;
+    memset(&request, 0, sizeof(request));
+    request.pCount = pCount;
+    request.pID = pID;
+    strcpy(request.program, program);
+
+    char control[CMSG_SPACE(sizeof(int) * 2)];
+    memset(control, 0, sizeof(control));
+    struct iovec part = {&request, sizeof(ZygoteRequest)};
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &part;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    struct cmsghdr* fdPart = CMSG_FIRSTHDR(&message);
+    fdPart->cmsg_level = SOL_SOCKET;
+    fdPart->cmsg_type = SCM_RIGHTS;
+    fdPart->cmsg_len = CMSG_LEN(sizeof(int) * 2);
+    int fds[2] = {input, output};
+    memcpy(CMSG_DATA(fdPart), fds, sizeof(int) * 2);
+
+    pid_t player = -1;
+    if(sendmsg(zygoteSocket, &message, MSG_NOSIGNAL) !=
+            sizeof(ZygoteRequest) || recv(zygoteSocket, &player,
+            sizeof(pid_t), 0) != sizeof(pid_t)) {
+        close(zygoteSocket); // the zygote is gone, exec from now on
+        zygoteSocket = -1;
+        return 0;
+    }
+    return player > 0 ? player : 0;
+}
@@ -0,0 +1,28 @@
+#ifndef ZYGOTE_H
+#define ZYGOTE_H
+
+#include <sys/types.h>
+#include "err.h"
+#include "options.h"
+
+// longest player program the zygote is asked to fork
+#define ZYGOTE_PATH 4096
+// player programs the zygote keeps loaded
+#define ZYGOTE_PROGRAMS 32
+
+// a player the hub asks the zygote to fork, sent with the player's end
+// of its stdin and stdout pipes
+typedef struct {
+    int pCount;
+    int pID;
+    char program[ZYGOTE_PATH];
+} ZygoteRequest;
+
+Error zygote_start(Options* options);
+
+pid_t zygote_spawn(char* program, int pCount, int pID, int input,
+        int output);
+
+void zygote_stop(void);
+
+#endif